@@ -0,0 +1,141 @@
+// Generated by tools/gen_bricks from 'BRICKS' in tetris.h.
+// Do not edit; run 'make bricks' after changing the shapes.
+#ifndef _VVC_BRICKS_H
+#define _VVC_BRICKS_H
+
+// Each brick row as a mask; bit N is set if column N is
+// filled. (The left-most column is bit 0.)
+// Indices: [ rotation ], [ brick type ], [ row ].
+static const uint8_t BRICK_ROWS[4][7][4] = {
+  { { 0x2, 0x2, 0x2, 0x2 },
+    { 0x0, 0x6, 0x6, 0x0 },
+    { 0x3, 0x2, 0x2, 0x0 },
+    { 0x6, 0x2, 0x2, 0x0 },
+    { 0x2, 0x7, 0x0, 0x0 },
+    { 0x2, 0x3, 0x1, 0x0 },
+    { 0x1, 0x3, 0x2, 0x0 } },
+  { { 0x0, 0xF, 0x0, 0x0 },
+    { 0x0, 0x6, 0x6, 0x0 },
+    { 0x4, 0x7, 0x0, 0x0 },
+    { 0x0, 0x7, 0x4, 0x0 },
+    { 0x2, 0x6, 0x2, 0x0 },
+    { 0x3, 0x6, 0x0, 0x0 },
+    { 0x6, 0x3, 0x0, 0x0 } },
+  { { 0x4, 0x4, 0x4, 0x4 },
+    { 0x0, 0x6, 0x6, 0x0 },
+    { 0x2, 0x2, 0x6, 0x0 },
+    { 0x2, 0x2, 0x3, 0x0 },
+    { 0x0, 0x7, 0x2, 0x0 },
+    { 0x4, 0x6, 0x2, 0x0 },
+    { 0x2, 0x6, 0x4, 0x0 } },
+  { { 0x0, 0x0, 0xF, 0x0 },
+    { 0x0, 0x6, 0x6, 0x0 },
+    { 0x0, 0x7, 0x1, 0x0 },
+    { 0x1, 0x7, 0x0, 0x0 },
+    { 0x2, 0x3, 0x2, 0x0 },
+    { 0x0, 0x3, 0x6, 0x0 },
+    { 0x0, 0x6, 0x3, 0x0 } }
+};
+// Left-most and right-most filled columns.
+static const uint8_t BRICK_LEFT[4][7] = {
+  { 1, 1, 0, 1, 0, 0, 0 },
+  { 0, 1, 0, 0, 1, 0, 0 },
+  { 2, 1, 1, 0, 0, 1, 1 },
+  { 0, 1, 0, 0, 0, 0, 0 }
+};
+static const uint8_t BRICK_RIGHT[4][7] = {
+  { 1, 2, 1, 2, 2, 1, 1 },
+  { 3, 2, 2, 2, 2, 2, 2 },
+  { 2, 2, 2, 1, 2, 2, 2 },
+  { 3, 2, 2, 2, 1, 2, 2 }
+};
+// Top-most and bottom-most filled rows.
+static const uint8_t BRICK_TOP[4][7] = {
+  { 0, 1, 0, 0, 0, 0, 0 },
+  { 1, 1, 0, 1, 0, 0, 0 },
+  { 0, 1, 0, 0, 1, 0, 0 },
+  { 2, 1, 1, 0, 0, 1, 1 }
+};
+static const uint8_t BRICK_BOTTOM[4][7] = {
+  { 3, 2, 2, 2, 1, 2, 2 },
+  { 1, 2, 1, 2, 2, 1, 1 },
+  { 3, 2, 2, 2, 2, 2, 2 },
+  { 2, 2, 2, 1, 2, 2, 2 }
+};
+// The 4 filled cells, top to bottom and left to right;
+// use 'BRICK_CELL_X' / 'BRICK_CELL_Y' to unpack them.
+static const uint8_t BRICK_CELLS[4][7][4] = {
+  { { 0x01, 0x11, 0x21, 0x31 },
+    { 0x11, 0x12, 0x21, 0x22 },
+    { 0x00, 0x01, 0x11, 0x21 },
+    { 0x01, 0x02, 0x11, 0x21 },
+    { 0x01, 0x10, 0x11, 0x12 },
+    { 0x01, 0x10, 0x11, 0x20 },
+    { 0x00, 0x10, 0x11, 0x21 } },
+  { { 0x10, 0x11, 0x12, 0x13 },
+    { 0x11, 0x12, 0x21, 0x22 },
+    { 0x02, 0x10, 0x11, 0x12 },
+    { 0x10, 0x11, 0x12, 0x22 },
+    { 0x01, 0x11, 0x12, 0x21 },
+    { 0x00, 0x01, 0x11, 0x12 },
+    { 0x01, 0x02, 0x10, 0x11 } },
+  { { 0x02, 0x12, 0x22, 0x32 },
+    { 0x11, 0x12, 0x21, 0x22 },
+    { 0x01, 0x11, 0x21, 0x22 },
+    { 0x01, 0x11, 0x20, 0x21 },
+    { 0x10, 0x11, 0x12, 0x21 },
+    { 0x02, 0x11, 0x12, 0x21 },
+    { 0x01, 0x11, 0x12, 0x22 } },
+  { { 0x20, 0x21, 0x22, 0x23 },
+    { 0x11, 0x12, 0x21, 0x22 },
+    { 0x10, 0x11, 0x12, 0x20 },
+    { 0x00, 0x10, 0x11, 0x12 },
+    { 0x01, 0x10, 0x11, 0x21 },
+    { 0x10, 0x11, 0x21, 0x22 },
+    { 0x11, 0x12, 0x20, 0x21 } }
+};
+// The bottom-most filled row in each column, or
+// 'BRICK_COL_EMPTY' for columns with no filled cells.
+static const uint8_t BRICK_COL_BOTTOM[4][7][4] = {
+  { { 0xFF, 0x03, 0xFF, 0xFF },
+    { 0xFF, 0x02, 0x02, 0xFF },
+    { 0x00, 0x02, 0xFF, 0xFF },
+    { 0xFF, 0x02, 0x00, 0xFF },
+    { 0x01, 0x01, 0x01, 0xFF },
+    { 0x02, 0x01, 0xFF, 0xFF },
+    { 0x01, 0x02, 0xFF, 0xFF } },
+  { { 0x01, 0x01, 0x01, 0x01 },
+    { 0xFF, 0x02, 0x02, 0xFF },
+    { 0x01, 0x01, 0x01, 0xFF },
+    { 0x01, 0x01, 0x02, 0xFF },
+    { 0xFF, 0x02, 0x01, 0xFF },
+    { 0x00, 0x01, 0x01, 0xFF },
+    { 0x01, 0x01, 0x00, 0xFF } },
+  { { 0xFF, 0xFF, 0x03, 0xFF },
+    { 0xFF, 0x02, 0x02, 0xFF },
+    { 0xFF, 0x02, 0x02, 0xFF },
+    { 0x02, 0x02, 0xFF, 0xFF },
+    { 0x01, 0x02, 0x01, 0xFF },
+    { 0xFF, 0x02, 0x01, 0xFF },
+    { 0xFF, 0x01, 0x02, 0xFF } },
+  { { 0x02, 0x02, 0x02, 0x02 },
+    { 0xFF, 0x02, 0x02, 0xFF },
+    { 0x02, 0x01, 0x01, 0xFF },
+    { 0x01, 0x01, 0x01, 0xFF },
+    { 0x01, 0x02, 0xFF, 0xFF },
+    { 0x01, 0x02, 0x02, 0xFF },
+    { 0x02, 0x02, 0x01, 0xFF } }
+};
+// The first rotation which fills the same cells as
+// each one, only shifted; or itself, if none does.
+static const uint8_t BRICK_SAME_ROT[4][7] = {
+  { 0, 0, 0, 0, 0, 0, 0 },
+  { 1, 0, 1, 1, 1, 1, 1 },
+  { 0, 0, 2, 2, 2, 0, 0 },
+  { 1, 0, 3, 3, 3, 1, 1 }
+};
+// Where each type of brick appears. (Rotation 0)
+static const int8_t BRICK_SPAWN_X[7] = { 4, 4, 4, 4, 4, 4, 4 };
+static const int8_t BRICK_SPAWN_Y[7] = { -1, -1, -1, -1, -1, -1, -1 };
+
+#endif
@@ -30,72 +30,129 @@ volatile unsigned char uled_state;
 #define GAME_STATE_IN_GAME    (1)
 #define GAME_STATE_PAUSED     (2)
 #define GAME_STATE_GAME_OVER  (3)
+#define GAME_STATE_ATTRACT    (4)
+#define GAME_STATE_REPLAY     (5)
 volatile uint8_t game_state;
 #define MAIN_MENU_STATE_START (0)
 volatile uint8_t main_menu_state;
-volatile uint32_t tetris_score;
-volatile uint8_t tetris_level;
-// Timer values for dropping the bricks faster
-// when the 'down' button is pressed.
-#define FAST_DROP_TIM_PRE     (2048)
-//#define FAST_DROP_TIM_ARR     (4096)
-#define FAST_DROP_TIM_ARR     (3584)
+// Frame scheduler timer values. (TIM17)
+// The prescaler gives (48MHz / 4800) = 10KHz ticks, and
+// one frame slot lasts (10000 / VVC_FRAME_HZ) of those.
+// ('VVC_FRAME_HZ', and the game's timing which is counted in
+//  frame slots, are in 'src/tetris_frame.h'.)
+#include "tetris_frame.h"
+#define FRAME_TIM_PRE         (4799)
+#define FRAME_TIM_ARR         ((10000 / VVC_FRAME_HZ) - 1)
 
-// Macro definitions for the Tetris grid/bricks.
-// (Note: The brick values should not be changed; the
-//  'BRICKS' const array relies on them. [TODO])
-#define TGRID_I       (0)
-#define TGRID_O       (1)
-#define TGRID_L       (2)
-#define TGRID_J       (3)
-#define TGRID_T       (4)
-#define TGRID_Z       (5)
-#define TGRID_S       (6)
-#define TGRID_EMPTY   (7)
-#define TGRID_CURRENT (8)
-#define TBRICK_I      TGRID_I
-#define TBRICK_O      TGRID_O
-#define TBRICK_L      TGRID_L
-#define TBRICK_J      TGRID_J
-#define TBRICK_T      TGRID_T
-#define TBRICK_Z      TGRID_Z
-#define TBRICK_S      TGRID_S
-// Define X/Y boundaries for each brick. Based on a 4x4 grid,
-// with the 'center of rotation' at (1,1).
-// Indices: [ rotation ], [ brick type ].
-// The uint16 value has the 4x4 grid, with each hex digit
-// representing a row. Most-Significant Bit = top rows.
-// (Try drawing them out - it helps.)
-static const uint16_t BRICKS[4][7] = {
-  // Ordering is 'I', 'O', 'L', 'J', 'T', 'Z', 'S'.
-  // 'Rotated by 0   degrees'
-  { 0x4444, 0x0660, 0xC440, 0x6440, 0x4E00, 0x4C80, 0x8C40 },
-  // 'Rotated by 90  degrees'
-  { 0x0F00, 0x0660, 0x2E00, 0x0E20, 0x4640, 0xC600, 0x6C00 },
-  // 'Rotated by 180 degrees'
-  { 0x2222, 0x0660, 0x4460, 0x44C0, 0x0E40, 0x2640, 0x4620 },
-  // 'Rotated by 270 degrees'
-  { 0x00F0, 0x0660, 0x0E80, 0x8E00, 0x4C40, 0x0C60, 0x06C0 }
-};
-// The Tetris grid; use a full byte per pixel. It's a
-// bit profligate, but we'll want to store color
-// in the V2 board and it'll make the math simple.
-volatile unsigned char tetris_grid[10][20];
+// Game rules and state. (Hardware-independent)
+#include "tetris.h"
+#include "tetris_ai.h"
+#include "tetris_moves.h"
+#include "replay.h"
+#include "oled_fill.h"
+// Palette index for the 'ghost' outline of where the current
+// brick would land. (Medium grey)
+#define TGRID_GHOST_COL (13)
+// The game being played, or watched in attract mode.
+tetris_game_t tetris_game;
+// The current brick and its landing row, as of the last
+// 'snapshot_tetris_game'. The in-game screen is drawn from
+// these, so that a button press can't move the brick while
+// a frame is being drawn.
+tetris_piece_t draw_piece;
+int8_t draw_ghost_y;
 // Store more information about the game state.
 volatile uint8_t should_tick;
 volatile uint8_t state_changed;
-volatile uint8_t fast_tick_timer_on;
-volatile uint8_t left_right_fast_tick;
-volatile uint16_t game_tick_prescaler;
-volatile uint16_t game_tick_period;
-// Store information about the current and next block.
-volatile uint8_t cur_block_type;
-volatile uint8_t next_block_type;
-volatile int8_t cur_block_x;
-volatile int8_t cur_block_y;
-volatile int8_t cur_block_r;
-
+// Frame scheduler state. 'frame_due' is set at the start of
+// each frame slot and cleared when a frame is drawn, so that
+// at most one frame is drawn per slot. 'frame_slot' counts
+// the slots. A 'dropped' frame is a slot which ended with a
+// state change that was never drawn; a 'late' frame is one
+// which took longer than the slot that it started in.
+volatile uint8_t frame_due;
+volatile uint32_t frame_slot;
+volatile uint32_t frames_dropped;
+volatile uint32_t frames_late;
+// Game timing state. ('game_frame') 'game_frame_slot' is the
+// last frame slot that it ran for. The button interrupts also
+// reset 'game_timing.shift_frames' when 'Left' / 'Right' are
+// pressed; 'game_frame' masks them while it runs.
+uint32_t game_frame_slot;
+tetris_frame_t game_timing;
+// Attract mode: after the main menu has been left alone for
+// a while, the computer plays a game until a button is
+// pressed or it loses. It gets 'VVC_AI_SLICE' percent of each
+// frame slot to search for moves. ('make AI_SLICE=25')
+#define ATTRACT_IDLE_SLOTS (10 * VVC_FRAME_HZ)
+#ifndef VVC_AI_SLICE
+  #define VVC_AI_SLICE (25)
+#endif
+#define AI_SLICE_TICKS (((FRAME_TIM_ARR + 1) * VVC_AI_SLICE) / 100)
+tetris_ai_t attract_ai;
+#ifdef VVC_AI_LOOKAHEAD
+// Transposition table for its lookahead. ('make AI_TT=64')
+// 'attract_tt.probes' / 'hits' count how well it does.
+  #ifndef VVC_AI_TT_SIZE
+    #define VVC_AI_TT_SIZE (64)
+  #endif
+  #if VVC_AI_TT_SIZE
+tetris_tt_entry_t attract_tt_entries[VVC_AI_TT_SIZE];
+tetris_tt_t attract_tt;
+  #endif
+#endif
+volatile uint32_t attract_idle_slots;
+// The brick that 'attract_ai' is placing, and the frame slot
+// of the last move it made.
+uint32_t attract_brick;
+uint32_t attract_move_slot;
+// The frame slot that the search last ran in, and the TIM17
+// count at which its share of that slot runs out.
+uint32_t attract_slice_slot;
+uint16_t attract_slice_end;
+// Placements that the search scored in the last second.
+uint32_t ai_evals_per_sec;
+uint32_t attract_rate_slot;
+uint32_t attract_rate_evals;
+// Game recording. ('make REPLAY=1') Each game played is
+// recorded in 'replay_log'; read it out with a debugger, e.g.
+//   (gdb) dump binary value replay.bin replay_log
+// and play it back with 'tools/replay'. Pressing 'Up' on the
+// 'Game Over' screen replays it on the board as fast as it
+// can, drawing every step, and the time taken is stored in
+// 'replay_bench_us'.
+#ifdef VVC_REPLAY
+  replay_log_t replay_log;
+  uint32_t replay_bench_us;
+  uint32_t replay_bench_events;
+  #define REPLAY_RECORD(ev) \
+    replay_record(&replay_log, (ev), frame_slot)
+  #define REPLAY_RECORD_SEED(seed) \
+    replay_record_seed(&replay_log, (seed), frame_slot)
+#else
+  #define REPLAY_RECORD(ev) do { (void)(ev); } while (0)
+  #define REPLAY_RECORD_SEED(seed) do { (void)(seed); } while (0)
+#endif
 // SSD1331 OLED information (96x64 pixels)
+// Accelerated drawing commands.
+#define SSD1331_CMD_DRAW_LINE    (0x21)
+#define SSD1331_CMD_DRAW_RECT    (0x22)
+#define SSD1331_CMD_COPY         (0x23)
+#define SSD1331_CMD_CLEAR_WINDOW (0x25)
+#define SSD1331_CMD_FILL_MODE    (0x26)
+// The SSD1331 has no 'busy' flag, so give its drawing engine
+// time to finish after each accelerated command. (Microseconds
+// for a command which touches 'px' pixels.) This is a guess;
+// it hasn't been measured on a panel, which is why 'OLED_ACCEL'
+// is off by default.
+#define SSD1331_ACCEL_WAIT_US(px) (10 + ((px) >> 4))
+// With the full framebuffer, changed regions of at least this
+// many solid-colored pixels are sent as drawing commands
+// instead of pixel data. ('make OLED_ACCEL=1' to enable)
+#if defined(VVC_OLED_ACCEL) && !defined(VVC_OLED_SCANLINE)
+  #define OLED_HW_ACCEL
+  #define OLED_ACCEL_MIN_PX (4)
+#endif
 // OLED colors.
 #define OLED_BLK    (0x0000)
 #define OLED_LGRN   (0x8628)
@@ -113,19 +170,61 @@ volatile int8_t cur_block_r;
 #define OLED_MGRY   (0x8C51)
 #define OLED_DGRY   (0x4A69)
 #define OLED_WHT    (0xFFFF)
-// Color palette.
-static const uint16_t oled_colors[16] = {
+// Default color palette.
+static const uint16_t oled_default_colors[16] = {
   OLED_BLK, OLED_LGRN, OLED_MGRN, OLED_DGRN,
   OLED_BRGNDY, OLED_YLW, OLED_ORNG, OLED_TEAL,
   OLED_PNK, OLED_BLU, OLED_PRP, OLED_BRWN,
   OLED_LGRY, OLED_MGRY, OLED_DGRY, OLED_WHT
 };
+// Active color palette. Change it with 'oled_set_color' so
+// that the expansion table below stays in sync.
+uint16_t oled_colors[16];
+// Expansion table for streaming the framebuffer. Each entry
+// holds the 4 RGB565 bytes for one framebuffer byte (2 pixels),
+// laid out in the order that they go out on the wire, so one
+// 32-bit load replaces the nibble / palette / byte-split work.
+// The full table is 1KB, which the 4KB-SRAM STM32F031 can't
+// spare next to a full framebuffer; without the scanline
+// renderer, it gets a 16-entry byte-swapped palette instead.
+#if !defined(STM32F031x6) || defined(VVC_OLED_SCANLINE)
+  #define OLED_EXPAND_LUT
+  uint32_t oled_expand_lut[256];
+#else
+  uint16_t oled_expand_lut[16];
+#endif
 // Buffer for the OLED screen.
 // To fit in 4KB of SRAM, use 4 bits per pixel, to
 // map to up to 16 colors defined above. So, 2px per byte.
 // (1 Byte = 2 pixels)
 #define OLED_FB_SIZE ((96 * 64) / 2)
-volatile uint8_t oled_fb[OLED_FB_SIZE];
+#define OLED_FB_ROW  (96 / 2)
+// With the scanline renderer, the buffer only holds a 'band'
+// of a few rows starting at 'oled_band_y'; each frame is drawn
+// one band at a time and streamed out as it goes. Otherwise,
+// the band is simply the whole screen.
+#ifdef VVC_OLED_SCANLINE
+  #define OLED_BAND_ROWS (2)
+#else
+  #define OLED_BAND_ROWS (64)
+#endif
+#define OLED_BUF_SIZE (OLED_FB_ROW * OLED_BAND_ROWS)
+// (Word-aligned, so that spans can be filled with 32-bit stores.
+//  Each row is 48 bytes, so every row starts on a word, too.)
+volatile uint8_t oled_fb[OLED_BUF_SIZE] __attribute__((aligned(4)));
+uint8_t oled_band_y;
+// Set while the framebuffer is being streamed to the display
+// in the background. (Only used by the SPI1/DMA backend)
+volatile uint8_t oled_stream_busy;
+// Regions of the framebuffer which have changed since they
+// were last sent to the display. (Inclusive pixel coordinates)
+// (Unused by the scanline renderer, which sends whole frames.)
+#define OLED_DIRTY_MAX (4)
+oled_rect_t oled_dirty[OLED_DIRTY_MAX];
+uint8_t oled_num_dirty;
+// Which screen (game state) the framebuffer currently holds.
+#define OLED_SCREEN_NONE (0xFF)
+uint8_t oled_fb_screen;
 // Buffer for drawing lines of text to the OLED.
 char oled_line_buf[18];
 
@@ -0,0 +1,159 @@
+#include "hspi.h"
+#include "util_c.h"
+
+// Ping-pong buffers for expanded RGB565 pixel data. One is
+// being sent by the DMA channel while the other gets filled.
+// (Word-sized so that they can be filled 2 pixels at a time)
+static uint32_t hspi_buf[2][HSPI_DMA_BUF_SIZE / 4];
+static volatile uint8_t hspi_buf_len[2];
+static volatile uint8_t hspi_dma_buf;
+// Next framebuffer byte to expand, the last byte in its row,
+// the number of bytes in each row, and the rows remaining.
+static volatile uint16_t hspi_fb_pos;
+static volatile uint16_t hspi_row_end;
+static volatile uint8_t hspi_row_bytes;
+static volatile uint8_t hspi_rows_left;
+
+/*
+ * Initialize the SPI1 peripheral and its DMA channel.
+ * The SSD1331 needs a serial clock cycle of at least 150ns,
+ * so use (PCLK / 8) = 6MHz. The bit-banged driver idles the
+ * clock high and latches data on the rising edge, so match
+ * that with CPOL = CPHA = 1. Only the 'MOSI' line is used, so
+ * put the peripheral in 'transmit-only' bidirectional mode
+ * to avoid receive overruns.
+ * (Expects the GPIOB, SPI1, and DMA clocks to be enabled.)
+ */
+void hspi_init(void) {
+  // Hand PB3 / PB5 over to the SPI1 peripheral (AF0).
+  GPIOB->MODER   &= ~(GPIO_MODER_MODER3 |
+                      GPIO_MODER_MODER5);
+  GPIOB->MODER   |=  (2 << GPIO_MODER_MODER3_Pos |
+                      2 << GPIO_MODER_MODER5_Pos);
+  GPIOB->AFR[0]  &= ~(GPIO_AFRL_AFRL3 |
+                      GPIO_AFRL_AFRL5);
+  // Reset and configure the SPI peripheral.
+  SPI1->CR1 &= ~(SPI_CR1_SPE);
+  RCC->APB2RSTR |=  (RCC_APB2RSTR_SPI1RST);
+  RCC->APB2RSTR &= ~(RCC_APB2RSTR_SPI1RST);
+  SPI1->CR1  =  (SPI_CR1_BIDIMODE |
+                 SPI_CR1_BIDIOE |
+                 SPI_CR1_SSM |
+                 SPI_CR1_SSI |
+                 SPI_CR1_MSTR |
+                 SPI_CR1_CPOL |
+                 SPI_CR1_CPHA |
+                 (0x2 << SPI_CR1_BR_Pos));
+  // 8-bit frames; let the DMA channel feed the TX FIFO.
+  SPI1->CR2  =  ((0x7 << SPI_CR2_DS_Pos) |
+                 SPI_CR2_FRXTH |
+                 SPI_CR2_TXDMAEN);
+  SPI1->CR1 |=  (SPI_CR1_SPE);
+  // SPI1_TX uses DMA1 Channel 3 on STM32F0 chips.
+  // Memory -> peripheral, increment memory address,
+  // 8-bit transfers, interrupt on 'transfer complete'.
+  DMA1_Channel3->CCR  &= ~(DMA_CCR_EN);
+  DMA1_Channel3->CCR   =  (DMA_CCR_MINC |
+                           DMA_CCR_DIR |
+                           DMA_CCR_TCIE);
+  DMA1_Channel3->CPAR  =  (uint32_t)&(SPI1->DR);
+  DMA1->IFCR           =  (DMA_IFCR_CGIF3);
+  oled_stream_busy = 0;
+}
+
+/*
+ * Write a byte of data using the SPI1 peripheral.
+ * Note that the data register must be written with a byte
+ * access; a half-word write would send two frames.
+ */
+void hspi_w(uint8_t dat) {
+  while (!(SPI1->SR & SPI_SR_TXE)) {};
+  *(volatile uint8_t*)&(SPI1->DR) = dat;
+}
+
+/*
+ * Write a 'Command byte' over the SPI1 peripheral.
+ * The 'D/C' pin must not change while earlier bytes are
+ * still being shifted out, so wait for the bus to go idle
+ * before and after the command.
+ */
+void hspi_cmd(uint8_t cdat) {
+  while (oled_stream_busy) {};
+  while (SPI1->SR & SPI_SR_BSY) {};
+  GPIOB->ODR &= ~(1 << PB_DC);
+  hspi_w(cdat);
+  while (SPI1->SR & (SPI_SR_FTLVL | SPI_SR_BSY)) {};
+  GPIOB->ODR |=  (1 << PB_DC);
+}
+
+/*
+ * Expand the next chunk of the current framebuffer region
+ * into a buffer of big-endian RGB565 pixels.
+ * Returns the number of bytes written.
+ */
+static uint8_t hspi_fill_buf(uint32_t* buf) {
+  uint8_t len = 0;
+  while (len < HSPI_DMA_BUF_SIZE && hspi_rows_left) {
+    buf[len >> 2] = oled_expand(oled_fb[hspi_fb_pos]);
+    len += 4;
+    if (hspi_fb_pos == hspi_row_end) {
+      // Move to the start of the region in the next row.
+      hspi_fb_pos += OLED_FB_ROW + 1 - hspi_row_bytes;
+      hspi_row_end += OLED_FB_ROW;
+      --hspi_rows_left;
+    }
+    else {
+      ++hspi_fb_pos;
+    }
+  }
+  return len;
+}
+
+/*
+ * Point the DMA channel at a new buffer and start it.
+ */
+static void hspi_dma_start(uint32_t* buf, uint8_t len) {
+  DMA1_Channel3->CCR  &= ~(DMA_CCR_EN);
+  DMA1_Channel3->CMAR  =  (uint32_t)buf;
+  DMA1_Channel3->CNDTR =  len;
+  DMA1_Channel3->CCR  |=  (DMA_CCR_EN);
+}
+
+/*
+ * Start streaming a region of the framebuffer to the display
+ * in the background. 'x0' must be even and 'x1' odd, so that
+ * each row covers whole framebuffer bytes. Both line buffers
+ * are filled before the first transfer starts; after that,
+ * the DMA interrupt refills whichever buffer has just been sent.
+ */
+void hspi_stream_rect(uint8_t x0, uint8_t y0,
+                      uint8_t x1, uint8_t y1) {
+  // Wait for any previous region to finish.
+  while (oled_stream_busy) {};
+  oled_stream_busy = 1;
+  hspi_fb_pos = (x0 + ((y0 - oled_band_y) * 96)) / 2;
+  hspi_row_end = (x1 + ((y0 - oled_band_y) * 96)) / 2;
+  hspi_row_bytes = (x1 - x0 + 1) / 2;
+  hspi_rows_left = y1 - y0 + 1;
+  hspi_buf_len[0] = hspi_fill_buf(hspi_buf[0]);
+  hspi_buf_len[1] = hspi_fill_buf(hspi_buf[1]);
+  hspi_dma_buf = 0;
+  hspi_dma_start(hspi_buf[0], hspi_buf_len[0]);
+}
+
+/*
+ * DMA 'transfer complete' handling: send the buffer which
+ * was filled in the meantime, then refill the one which
+ * just finished. Clears 'oled_stream_busy' at the end.
+ */
+void hspi_dma_tx_complete(void) {
+  uint8_t next_buf = !hspi_dma_buf;
+  if (hspi_buf_len[next_buf] == 0) {
+    DMA1_Channel3->CCR &= ~(DMA_CCR_EN);
+    oled_stream_busy = 0;
+    return;
+  }
+  hspi_dma_start(hspi_buf[next_buf], hspi_buf_len[next_buf]);
+  hspi_dma_buf = next_buf;
+  hspi_buf_len[!next_buf] = hspi_fill_buf(hspi_buf[!next_buf]);
+}
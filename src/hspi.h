@@ -0,0 +1,35 @@
+#ifndef _VVC_HSPI_H
+#define _VVC_HSPI_H
+
+#include "global.h"
+#include "sspi.h"
+
+// Size of each DMA line buffer, in bytes. (48 pixels @ RGB565,
+// or half of a display row.) Two are used in a ping-pong fashion.
+#define HSPI_DMA_BUF_SIZE (96)
+
+// Methods for the hardware SPI1 peripheral.
+// PB3 = SCK, PB5 = MOSI (Alternate Function 0).
+void hspi_init(void);
+// Write a byte of data using the SPI1 peripheral.
+void hspi_w(uint8_t dat);
+// Write a 'command' byte for 4-wire SPI interfaces.
+void hspi_cmd(uint8_t cdat);
+// Start streaming a framebuffer region over DMA. Returns
+// immediately; 'oled_stream_busy' is cleared when it finishes.
+void hspi_stream_rect(uint8_t x0, uint8_t y0,
+                      uint8_t x1, uint8_t y1);
+// Called from the DMA interrupt when a line buffer has been sent.
+void hspi_dma_tx_complete(void);
+
+// Display bus write methods; select the SPI1 peripheral or
+// the bit-banged fallback at compile time. (See Makefile)
+#ifdef VVC_HSPI
+  #define oled_w(dat)   hspi_w(dat)
+  #define oled_cmd(dat) hspi_cmd(dat)
+#else
+  #define oled_w(dat)   sspi_w(dat)
+  #define oled_cmd(dat) sspi_cmd(dat)
+#endif
+
+#endif
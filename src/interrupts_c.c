@@ -12,32 +12,51 @@
  */
 // Common definitions for each line, independent of
 // available NVIC interrupts on any specific chip.
+/*
+ * Any button press ends attract mode, and goes back to the
+ * main menu. Returns 1 if it did, so that the press is
+ * otherwise ignored.
+ */
+static uint8_t attract_interrupted(void) {
+  if (game_state != GAME_STATE_ATTRACT) { return 0; }
+  game_state = GAME_STATE_MAIN_MENU;
+  main_menu_state = MAIN_MENU_STATE_START;
+  uled_state = 0;
+  should_tick = 0;
+  state_changed = 1;
+  return 1;
+}
+
 inline void EXTI0_line_interrupt(void) {
   // 'Down' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_IN_GAME) {
-    // Drop the block by one grid coordinate if able.
-    should_tick = 1;
-    if (!fast_tick_timer_on) {
-      fast_tick_timer_on = 1;
-      // Start the timer for continuing to drop bricks.
-      start_timer(TIM16, FAST_DROP_TIM_PRE, FAST_DROP_TIM_ARR, 1);
+    // Drop the block by one grid coordinate if able. A brick
+    // which has landed is left to the lock delay, like it is
+    // while 'Down' is held. ('game_frame')
+    if (!check_brick_pos(&tetris_game, tetris_game.cur.x,
+                         tetris_game.cur.y+1)) {
+      REPLAY_RECORD(REPLAY_EV_TICK);
+      tetris_game_tick(&tetris_game);
+      game_timing.lock_frames = 0;
+      state_changed = 1;
     }
   }
 }
 
 inline void EXTI1_line_interrupt(void) {
   // 'Right' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_IN_GAME) {
     // Move the brick right, if possible.
-    if (!check_brick_pos(cur_block_x+1, cur_block_y)) {
-      cur_block_x += 1;
+    if (!check_brick_pos(&tetris_game, tetris_game.cur.x+1,
+                         tetris_game.cur.y)) {
+      tetris_game.cur.x += 1;
+      REPLAY_RECORD(REPLAY_EV_RIGHT);
       state_changed = 1;
-      if (!fast_tick_timer_on) {
-        fast_tick_timer_on = 1;
-        // Start the timer for continuing to drop bricks.
-        start_timer(TIM16, FAST_DROP_TIM_PRE, FAST_DROP_TIM_ARR, 1);
-      }
     }
+    // (While it's held, 'game_frame' repeats the move.)
+    game_timing.shift_frames = 0;
   }
 }
 
@@ -55,43 +74,62 @@ inline void EXTI5_line_interrupt(void) {
 
 inline void EXTI6_line_interrupt(void) {
   // 'Left' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_IN_GAME) {
     // Move the brick left, if possible.
-    if (!check_brick_pos(cur_block_x-1, cur_block_y)) {
-      cur_block_x -= 1;
+    if (!check_brick_pos(&tetris_game, tetris_game.cur.x-1,
+                         tetris_game.cur.y)) {
+      tetris_game.cur.x -= 1;
+      REPLAY_RECORD(REPLAY_EV_LEFT);
       state_changed = 1;
-      if (!fast_tick_timer_on) {
-        fast_tick_timer_on = 1;
-        // Start the timer for continuing to drop bricks.
-        start_timer(TIM16, FAST_DROP_TIM_PRE, FAST_DROP_TIM_ARR, 1);
-      }
     }
+    game_timing.shift_frames = 0;
   }
 }
 
 inline void EXTI7_line_interrupt(void) {
   // 'Up' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_IN_GAME) {
-    // For now, 'Up' pauses the game.
-    game_state = GAME_STATE_PAUSED;
-    stop_timer(TIM2);
+    if (!(GPIOB->IDR & GPIO_IDR_0)) {
+      // 'Up' with 'Down' held pauses the game.
+      game_state = GAME_STATE_PAUSED;
+    }
+    else {
+      // Otherwise, 'Up' is a hard drop: move the brick
+      // straight to where it would land, and let the next
+      // tick lock it in place. (Without waiting for the lock
+      // delay; that's what a hard drop is for.)
+      tetris_game.cur.y = tetris_landing_row(&tetris_game);
+      REPLAY_RECORD(REPLAY_EV_DROP);
+      should_tick = 1;
+      state_changed = 1;
+    }
   }
   else if (game_state == GAME_STATE_PAUSED) {
     game_state = GAME_STATE_IN_GAME;
-    start_timer(TIM2, game_tick_prescaler, game_tick_period, 1);
     state_changed = 1;
   }
+#ifdef VVC_REPLAY
+  else if (game_state == GAME_STATE_GAME_OVER) {
+    // Replay the game which just ended, as a benchmark.
+    if (replay_complete(&replay_log)) {
+      game_state = GAME_STATE_REPLAY;
+    }
+  }
+#endif
 }
 
 inline void EXTI8_line_interrupt(void) {
   // 'B' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_MAIN_MENU) {
   }
   else if (game_state == GAME_STATE_IN_GAME) {
     // Rotate the brick clockwise, if able.
-    if (!check_brick_rot((cur_block_r + 3) % 4)) {
-      cur_block_r = (cur_block_r + 3) % 4;
-      if (cur_block_r < 0) { cur_block_r = -cur_block_r; }
+    if (!check_brick_rot(&tetris_game, (tetris_game.cur.r + 3) % 4)) {
+      tetris_game.cur.r = (tetris_game.cur.r + 3) % 4;
+      REPLAY_RECORD(REPLAY_EV_ROT_CW);
       state_changed = 1;
     }
   }
@@ -103,8 +141,6 @@ inline void EXTI8_line_interrupt(void) {
     game_state = GAME_STATE_MAIN_MENU;
     main_menu_state = MAIN_MENU_STATE_START;
     uled_state = 0;
-    stop_timer(TIM2);
-    stop_timer(TIM16);
     reset_game_state();
     state_changed = 1;
   }
@@ -112,29 +148,26 @@ inline void EXTI8_line_interrupt(void) {
 
 inline void EXTI9_line_interrupt(void) {
   // 'A' button.
+  if (attract_interrupted()) { return; }
   if (game_state == GAME_STATE_MAIN_MENU) {
     if (main_menu_state == MAIN_MENU_STATE_START) {
       // Start a new game!
       game_state = GAME_STATE_IN_GAME;
       uled_state = 0;
-      // Set a PRNG-based first block type.
-      uint8_t new_block_type = TIM3->CNT & 0x7;
-      // (Valid block types are between [0:6])
-      while (new_block_type == 7) { new_block_type = TIM3->CNT & 0x7; }
-      cur_block_type = new_block_type;
-      start_timer(TIM2, game_tick_prescaler, game_tick_period, 1);
-      // Set a PRNG-based next block type.
-      new_block_type = TIM3->CNT & 0x7;
-      // (Valid block types are between [0:6])
-      while (new_block_type == 7) { new_block_type = TIM3->CNT & 0x7; }
-      next_block_type = new_block_type;
+      // Clear the frame tick's counters, which an attract mode
+      // game may have left behind, and deal the first bricks
+      // from a new sequence.
+      reset_game_state();
+      tetris_new_game(&tetris_game);
+      REPLAY_RECORD_SEED(tetris_game.rng.seed);
       state_changed = 1;
     }
   }
   else if (game_state == GAME_STATE_IN_GAME) {
     // Rotate the brick counter-clockwise, if able.
-    if (!check_brick_rot((cur_block_r + 1) % 4)) {
-      cur_block_r = (cur_block_r + 1) % 4;
+    if (!check_brick_rot(&tetris_game, (tetris_game.cur.r + 1) % 4)) {
+      tetris_game.cur.r = (tetris_game.cur.r + 1) % 4;
+      REPLAY_RECORD(REPLAY_EV_ROT_CCW);
       state_changed = 1;
     }
   }
@@ -146,8 +179,6 @@ inline void EXTI9_line_interrupt(void) {
     game_state = GAME_STATE_MAIN_MENU;
     main_menu_state = MAIN_MENU_STATE_START;
     uled_state = 0;
-    stop_timer(TIM2);
-    stop_timer(TIM16);
     reset_game_state();
     state_changed = 1;
   }
@@ -264,6 +295,17 @@ if (EXTI->PR & EXTI_PR_PR15) {
 return;
 }
 
+/*
+ * DMA1_chan2_3: Handle DMA channels 2 and 3.
+ * Channel 3 feeds the SPI1 peripheral's TX FIFO.
+ */
+void DMA1_chan2_3_IRQ_handler(void) {
+if (DMA1->ISR & DMA_ISR_TCIF3) {
+  DMA1->IFCR = DMA_IFCR_CTCIF3;
+  hspi_dma_tx_complete();
+}
+return;
+}
 
 #elif VVC_F3
 // STM32F3xx(?) EXTI lines.
@@ -310,53 +352,27 @@ return;
 #endif
 
 // Interrupts common to all supported chips.
-void TIM2_IRQ_handler(void) {
-  // Handle a timer 'update' interrupt event
-  if (TIM2->SR & TIM_SR_UIF) {
-    TIM2->SR &= ~(TIM_SR_UIF);
-    uled_state = !uled_state;
-    if (game_state == GAME_STATE_IN_GAME) {
-      should_tick = 1;
+/*
+ * Frame scheduler timer; starts a new frame slot. This is the
+ * game's only clock: the main loop runs 'game_frame' once for
+ * each slot.
+ */
+void TIM17_IRQ_handler(void) {
+  if (TIM17->SR & TIM_SR_UIF) {
+    TIM17->SR &= ~(TIM_SR_UIF);
+    // A change which was waiting for the slot that just
+    // ended didn't get drawn in time.
+    if (frame_due && state_changed) {
+      ++frames_dropped;
     }
-  }
-}
-
-void TIM16_IRQ_handler(void) {
-  // Handle a timer 'update' interrupt event
-  if (TIM16->SR & TIM_SR_UIF) {
-    TIM16->SR &= ~(TIM_SR_UIF);
-    // Stop the timer if no relevant buttons are pressed.
-    if ((GPIOB->IDR & GPIO_IDR_0) &&
-        (GPIOB->IDR & GPIO_IDR_1) &&
-        (GPIOA->IDR & GPIO_IDR_6)) {
-      fast_tick_timer_on = 0;
-      left_right_fast_tick = 0;
-      stop_timer(TIM16);
+    frame_due = 1;
+    ++frame_slot;
+    // Count how long the main menu has been left alone.
+    if (game_state == GAME_STATE_MAIN_MENU) {
+      ++attract_idle_slots;
     }
-    else if (game_state == GAME_STATE_IN_GAME) {
-      // If the game isn't paused, move the brick appropriately.
-      left_right_fast_tick += 1;
-      if (left_right_fast_tick >= 3) {
-        if (!(GPIOB->IDR & GPIO_IDR_1)) {
-          // Move the brick right, if possible.
-          if (!check_brick_pos(cur_block_x+1, cur_block_y)) {
-            cur_block_x += 1;
-            state_changed = 1;
-          }
-        }
-        if (!(GPIOA->IDR & GPIO_IDR_6)) {
-          // Move the brick left, if possible.
-          if (!check_brick_pos(cur_block_x-1, cur_block_y)) {
-            cur_block_x -= 1;
-            state_changed = 1;
-          }
-        }
-        left_right_fast_tick = 0;
-      }
-      if (!(GPIOB->IDR & GPIO_IDR_0)) {
-        // Drop the brick if necessary.
-        should_tick = 1;
-      }
+    else {
+      attract_idle_slots = 0;
     }
   }
 }
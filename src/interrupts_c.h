@@ -36,6 +36,8 @@ void EXTI0_1_IRQ_handler(void);
 void EXTI2_3_IRQ_handler(void);
 // EXTI handler for interrupt lines 4-15.
 void EXTI4_15_IRQ_handler(void);
+// DMA1 handler for channels 2-3. (SPI1 TX)
+void DMA1_chan2_3_IRQ_handler(void);
 #elif VVC_F3
 // STM32F3xx(?) EXTI lines.
 // EXTI handler for interrupt line 0.
@@ -55,7 +57,6 @@ void EXTI5_9_IRQ_handler(void);
 #endif
 
 // Handlers common to all supported lines of chip.
-void TIM2_IRQ_handler(void);
-void TIM16_IRQ_handler(void);
+void TIM17_IRQ_handler(void);
 
 #endif
@@ -35,25 +35,36 @@ int main(void) {
   main_menu_state = MAIN_MENU_STATE_START;
   should_tick = 0;
   state_changed = 1;
-  fast_tick_timer_on = 0;
-  left_right_fast_tick = 0;
-  tetris_score = 0;
-  tetris_level = 0;
-  game_tick_prescaler = 1024;
-  game_tick_period = 46785;
-  cur_block_type = TBRICK_I;
-  next_block_type = TBRICK_I;
-  cur_block_x = 4;
-  cur_block_y = -1;
-  cur_block_r = 0;
+  frame_due = 1;
+  frame_slot = 0;
+  frames_dropped = 0;
+  frames_late = 0;
+  attract_idle_slots = 0;
+  attract_move_slot = 0;
+  attract_slice_slot = 0;
+  attract_slice_end = 0;
+  attract_ai.evals = 0;
+  #if defined(VVC_AI_LOOKAHEAD) && VVC_AI_TT_SIZE
+  tetris_tt_init(&attract_tt, attract_tt_entries, VVC_AI_TT_SIZE);
+  attract_ai.tt = &attract_tt;
+  #endif
+  ai_evals_per_sec = 0;
+  game_frame_slot = 0;
+  tetris_frame_reset(&game_timing, 0);
+  oled_stream_busy = 0;
+  oled_num_dirty = 0;
+  oled_band_y = 0;
+  oled_fb_screen = OLED_SCREEN_NONE;
+  oled_init_palette();
+  // The display's RAM holds garbage at power-on, so the
+  // first frame needs to send every pixel.
+  oled_mark_dirty(0, 0, 95, 63);
+  tetris_game.score = 0;
+  tetris_game.level = 0;
+  tetris_game.cur.type = TBRICK_I;
+  tetris_game.next_type = TBRICK_I;
   // Empty the tetris grid, to start.
-  uint8_t grid_x_i = 0;
-  uint8_t grid_y_i = 0;
-  for (grid_x_i = 0; grid_x_i < 10; ++grid_x_i) {
-    for (grid_y_i = 0; grid_y_i < 20; ++grid_y_i) {
-      tetris_grid[grid_x_i][grid_y_i] = TGRID_EMPTY;
-    }
-  }
+  tetris_reset_board(&tetris_game);
 
   // Enable the GPIOA clock (buttons on pins A2-A7,
   // user LED on pin A12).
@@ -61,20 +72,24 @@ int main(void) {
   // Enable the GPIOB clock (I2C1 used on pins B6/B7,
   // buzzer on pin B0).
   RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
-  // Enable the TIM2 clock.
-  RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
   // Enable the TIM3 clock.
   RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
-  // Enable the TIM16 clock.
-  RCC->APB2ENR |= RCC_APB2ENR_TIM16EN;
+  // Enable the TIM17 clock. (Frame scheduler)
+  RCC->APB2ENR |= RCC_APB2ENR_TIM17EN;
   // Enable the I2C1 clock.
   RCC->APB1ENR |= RCC_APB1ENR_I2C1EN;
   // Enable the SYSCFG clock for hardware interrupts.
   RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+  #ifdef VVC_HSPI
+    // Enable the SPI1 and DMA clocks for the display.
+    RCC->APB2ENR |= RCC_APB2ENR_SPI1EN;
+    RCC->AHBENR  |= RCC_AHBENR_DMAEN;
+  #endif
 
-  // Start the TIM14 clock to count rapidly.
-  // This will be a rudimentary PRNG.
+  // Start the TIM3 clock to count rapidly; its count when a
+  // game starts seeds the brick randomizer.
   start_timer(TIM3, 0, 0xFFFF, 0);
+  tetris_rng_init(&tetris_game.rng, tetris_plat_rng_seed());
 
   // Setup GPIO pins A6, A7, A8, A9, B0, and B1 as inputs
   // with pullups, low-speed.
@@ -144,6 +159,11 @@ int main(void) {
                       GPIO_PUPDR_PUPDR4 |
                       GPIO_PUPDR_PUPDR5);
 
+  #ifdef VVC_HSPI
+    // Hand the SCK / MOSI pins to the SPI1 peripheral.
+    hspi_init();
+  #endif
+
   // Initialize the SSD1331 OLED display.
   GPIOA->ODR &= ~(1 << PA_CS);
   GPIOB->ODR |=  (1 << PB_DC);
@@ -153,6 +173,14 @@ int main(void) {
   delay_ms(150);
   ssd1331_start_sequence();
 
+  #ifdef VVC_PROFILE
+    // Start the cycle counter, and take startup measurements.
+    PROFILE_INIT();
+    oled_profile_expand();
+    oled_profile_fill();
+    profile_moves();
+  #endif
+
   // Setup hardware interrupts on the EXTI lines associated
   // with the 6 button inputs.
   // Pins B0, B1 use the EXTI0_1 interrupt.
@@ -213,41 +241,95 @@ int main(void) {
     NVIC_EnableIRQ(EXTI9_5_IRQn);
   #endif
 
-  // Enable the NVIC interrupt for TIM2 and TIM16.
-  // (Timer peripheral initialized and used elsewhere)
-  NVIC_SetPriority(TIM2_IRQn, 0x03);
-  NVIC_EnableIRQ(TIM2_IRQn);
-  NVIC_SetPriority(TIM16_IRQn, 0x03);
-  NVIC_EnableIRQ(TIM16_IRQn);
+  // Enable the NVIC interrupt for the frame scheduler, TIM17.
+  NVIC_SetPriority(TIM17_IRQn, 0x03);
+  NVIC_EnableIRQ(TIM17_IRQn);
+  // Start the frame scheduler's timer.
+  start_timer(TIM17, FRAME_TIM_PRE, FRAME_TIM_ARR, 1);
+  #ifdef VVC_HSPI
+    // Enable the NVIC interrupt for the display's DMA channel.
+    NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0x02);
+    NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+  #endif
+  #ifdef VVC_PROFILE
+    // Time a whole frame going out to the display.
+    oled_profile_frame();
+  #endif
 
   while (1) {
-    // Tick the game state if necessary.
+    // Run the game's timing once for each frame slot. (If
+    // drawing a frame held the loop up, it catches up a slot
+    // per pass.)
+    if (game_frame_slot != frame_slot) {
+      ++game_frame_slot;
+      game_frame();
+    }
+
+    // Tick the game state if a button or the computer player
+    // asked for it.
     if (should_tick) {
-      tetris_game_tick();
+      // The button interrupts move the current brick too, so
+      // don't let one slip in partway through a tick. (With
+      // 'REPLAY', the tick is recorded in the same place.)
+      __disable_irq();
+      #ifdef VVC_REPLAY
+        if (game_state == GAME_STATE_IN_GAME) {
+          REPLAY_RECORD(REPLAY_EV_TICK);
+        }
+      #endif
+      tetris_game_tick(&tetris_game);
+      __enable_irq();
       should_tick = 0;
       state_changed = 1;
     }
 
-    if (state_changed) {
+    // Let the computer play if the menu has been idle.
+    if ((game_state == GAME_STATE_MAIN_MENU) &&
+        (attract_idle_slots >= ATTRACT_IDLE_SLOTS)) {
+      attract_start();
+    }
+    else if (game_state == GAME_STATE_ATTRACT) {
+      attract_step();
+    }
+    #ifdef VVC_REPLAY
+      else if (game_state == GAME_STATE_REPLAY) {
+        replay_benchmark();
+        game_state = GAME_STATE_GAME_OVER;
+        state_changed = 1;
+      }
+    #endif
+
+    // Draw at most one frame per frame slot, covering every
+    // state change since the last one. A change in an idle
+    // slot is drawn right away, and later ones in the same
+    // slot wait for the next. (Don't draw over the framebuffer
+    // while it is still being streamed to the display.)
+    if (frame_due && state_changed && !oled_stream_busy) {
+      uint32_t start_slot = frame_slot;
+      frame_due = 0;
       state_changed = 0;
-      // Draw the current frame based on the game's state.
+      // Draw the current frame based on the game's state,
+      // and communicate it to the OLED screen.
       if (game_state == GAME_STATE_MAIN_MENU) {
-        draw_main_menu();
+        oled_render_frame(draw_main_menu);
       }
-      else if (game_state == GAME_STATE_IN_GAME) {
-        draw_tetris_game();
+      else if ((game_state == GAME_STATE_IN_GAME) ||
+               (game_state == GAME_STATE_ATTRACT)) {
+        snapshot_tetris_game();
+        oled_render_frame(draw_tetris_game);
       }
       else if (game_state == GAME_STATE_PAUSED) {
         // (TODO)
       }
       else if (game_state == GAME_STATE_GAME_OVER) {
-        draw_game_over();
+        oled_render_frame(draw_game_over);
       }
       else {
-        oled_draw_rect(0, 0, 128, 64, 0, 1);
+        oled_render_frame(draw_blank_screen);
+      }
+      if (frame_slot != start_slot) {
+        ++frames_late;
       }
-      // Communicate the framebuffer to the OLED screen.
-      sspi_stream_framebuffer();
     }
 
     // Set the onboard LED if the variable is set.
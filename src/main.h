@@ -6,5 +6,6 @@
 #include "interrupts_c.h"
 #include "peripherals.h"
 #include "sspi.h"
+#include "hspi.h"
 
 #endif
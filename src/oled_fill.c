@@ -0,0 +1,108 @@
+#include "oled_fill.h"
+
+/*
+ * Fill pixels 'x0' to 'x1' (inclusive) of one framebuffer row
+ * with 'color'. A leading odd pixel and a trailing even pixel
+ * are written as single nibbles; the whole bytes in between
+ * are filled with 32-bit stores of the replicated color, once
+ * they reach a word boundary. Words and bytes are only written
+ * if they differ, so unchanged areas are not reported.
+ * Returns 1 and sets the changed range if anything changed.
+ * (The range can include some pixels which already had the
+ *  same color; they are still correct on the display.)
+ * Expects a span which is clipped to the display.
+ */
+uint8_t oled_fill_span(volatile uint8_t* fb_row, int x0, int x1,
+                       uint8_t color,
+                       int* changed_x0, int* changed_x1) {
+  uint8_t c_nib = color & 0x0F;
+  uint8_t c_byte = c_nib | (c_nib << 4);
+  uint32_t c_word = c_byte * 0x01010101UL;
+  int b_pos = x0 >> 1;
+  int b_end = x1 >> 1;
+  int first_x = -1;
+  int last_x = -1;
+  // Leading odd pixel; the low nibble of its byte.
+  if (x0 & 1) {
+    if ((fb_row[b_pos] & 0x0F) != c_nib) {
+      fb_row[b_pos] = (fb_row[b_pos] & 0xF0) | c_nib;
+      first_x = x0;
+      last_x = x0;
+    }
+    ++b_pos;
+  }
+  // (A trailing even pixel is written on its own, below.)
+  if (!(x1 & 1)) { --b_end; }
+  // Whole bytes, up to the first word boundary.
+  while ((b_pos <= b_end) && (b_pos & 0x3)) {
+    if (fb_row[b_pos] != c_byte) {
+      fb_row[b_pos] = c_byte;
+      if (first_x < 0) { first_x = b_pos * 2; }
+      last_x = b_pos * 2 + 1;
+    }
+    ++b_pos;
+  }
+  // Whole words.
+  while (b_pos + 3 <= b_end) {
+    if (*(volatile uint32_t*)&fb_row[b_pos] != c_word) {
+      *(volatile uint32_t*)&fb_row[b_pos] = c_word;
+      if (first_x < 0) { first_x = b_pos * 2; }
+      last_x = b_pos * 2 + 7;
+    }
+    b_pos += 4;
+  }
+  // Any remaining whole bytes.
+  while (b_pos <= b_end) {
+    if (fb_row[b_pos] != c_byte) {
+      fb_row[b_pos] = c_byte;
+      if (first_x < 0) { first_x = b_pos * 2; }
+      last_x = b_pos * 2 + 1;
+    }
+    ++b_pos;
+  }
+  // Trailing even pixel; the high nibble of its byte.
+  if (!(x1 & 1)) {
+    b_pos = x1 >> 1;
+    if ((fb_row[b_pos] >> 4) != c_nib) {
+      fb_row[b_pos] = (fb_row[b_pos] & 0x0F) | (c_nib << 4);
+      if (first_x < 0) { first_x = x1; }
+      last_x = x1;
+    }
+  }
+  if (first_x < 0) { return 0; }
+  *changed_x0 = first_x;
+  *changed_x1 = last_x;
+  return 1;
+}
+
+/*
+ * Fill a rectangle of a framebuffer band, one span per row,
+ * and work out the area which changed. Coordinates are
+ * inclusive, and must already be clipped to the display and
+ * to the rows which the band holds.
+ */
+uint8_t oled_fill_rows(volatile uint8_t* fb, int band_y,
+                       int x0, int y0, int x1, int y1,
+                       uint8_t color, oled_rect_t* changed) {
+  int y_pos;
+  int span_x0, span_x1;
+  int dirty_x0 = 96;
+  int dirty_x1 = -1;
+  int dirty_y0 = -1;
+  int dirty_y1 = -1;
+  for (y_pos = y0; y_pos <= y1; ++y_pos) {
+    if (oled_fill_span(&fb[(y_pos - band_y) * 48], x0, x1, color,
+                       &span_x0, &span_x1)) {
+      if (span_x0 < dirty_x0) { dirty_x0 = span_x0; }
+      if (span_x1 > dirty_x1) { dirty_x1 = span_x1; }
+      if (dirty_y0 < 0) { dirty_y0 = y_pos; }
+      dirty_y1 = y_pos;
+    }
+  }
+  if (dirty_y0 < 0) { return 0; }
+  changed->x0 = dirty_x0;
+  changed->y0 = dirty_y0;
+  changed->x1 = dirty_x1;
+  changed->y1 = dirty_y1;
+  return 1;
+}
@@ -0,0 +1,32 @@
+#ifndef _VVC_OLED_FILL_H
+#define _VVC_OLED_FILL_H
+
+#include <stdint.h>
+
+// Fill kernels for the 4-bit framebuffer: two pixels per byte,
+// with the even (left) pixel in the high nibble, and 48 bytes
+// per row. They don't touch any hardware, so 'make bench-fill'
+// can also time them on a PC. (See tools/bench_fill.c)
+
+// An area of the display. (Inclusive pixel coordinates)
+typedef struct {
+  uint8_t x0;
+  uint8_t y0;
+  uint8_t x1;
+  uint8_t y1;
+} oled_rect_t;
+
+// Fill pixels 'x0' to 'x1' of one framebuffer row with 'color'.
+// Returns 1 and sets the changed range if anything changed.
+// ('fb_row' must be word-aligned.)
+uint8_t oled_fill_span(volatile uint8_t* fb_row, int x0, int x1,
+                       uint8_t color,
+                       int* changed_x0, int* changed_x1);
+// Fill a rectangle of a framebuffer band whose first row is
+// display row 'band_y', one span per row. Returns 1 and sets
+// the area which changed if anything changed.
+uint8_t oled_fill_rows(volatile uint8_t* fb, int band_y,
+                       int x0, int y0, int x1, int y1,
+                       uint8_t color, oled_rect_t* changed);
+
+#endif
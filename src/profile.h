@@ -0,0 +1,39 @@
+#ifndef _VVC_PROFILE_H
+#define _VVC_PROFILE_H
+
+#include "global.h"
+
+// Cycle-counting helpers for profiling builds. ('make PROFILE=1')
+// The Cortex-M0 has no cycle counter, so let the 24-bit SysTick
+// timer free-run from the core clock and take differences.
+// Spans longer than 2^24 cycles (~350ms @ 48MHz) will wrap.
+#ifdef VVC_PROFILE
+  #define PROFILE_INIT() do {                         \
+    SysTick->LOAD = 0x00FFFFFF;                       \
+    SysTick->VAL  = 0;                                \
+    SysTick->CTRL = (SysTick_CTRL_CLKSOURCE_Msk |     \
+                     SysTick_CTRL_ENABLE_Msk);        \
+  } while (0)
+  #define PROFILE_NOW()        (SysTick->VAL)
+  #define PROFILE_SINCE(t0)    (((t0) - SysTick->VAL) & 0x00FFFFFF)
+
+  // Measured results; read them out with a debugger.
+  // Cycles to expand one full frame into display bytes, using
+  // the old per-nibble palette lookups and the expansion table.
+  volatile uint32_t prof_expand_ref_cycles;
+  volatile uint32_t prof_expand_lut_cycles;
+  // Cycles to fill the whole framebuffer with one color, using
+  // the old per-pixel line loop and the span fill kernel.
+  volatile uint32_t prof_fill_ref_cycles;
+  volatile uint32_t prof_fill_span_cycles;
+  // Cycles to draw the main menu and send all of it to the
+  // display with 'oled_render_frame'.
+  volatile uint32_t prof_frame_cycles;
+  // Cycles for one call to the move generator on a test grid,
+  // and how many lock positions it found. (Placements per
+  // second = found * 48MHz / cycles)
+  volatile uint32_t prof_moves_cycles;
+  volatile uint32_t prof_moves_found;
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#include "replay.h"
+
+/*
+ * Append one byte to the log's ring buffer.
+ */
+static void replay_put(replay_log_t* log, uint8_t dat) {
+  log->buf[log->len & REPLAY_LOG_MASK] = dat;
+  ++log->len;
+}
+
+/*
+ * Append an event, with the time since the previous one.
+ */
+void replay_record(replay_log_t* log, uint8_t ev, uint32_t slot) {
+  uint32_t delta = slot - log->last_slot;
+  log->last_slot = slot;
+  while (delta > REPLAY_DELTA_MAX) {
+    replay_put(log, (REPLAY_EV_WAIT << REPLAY_EV_SHIFT) |
+                    REPLAY_DELTA_MAX);
+    delta -= REPLAY_DELTA_MAX;
+  }
+  replay_put(log, (ev << REPLAY_EV_SHIFT) | delta);
+}
+
+/*
+ * Start a new recording with a game's brick seed.
+ */
+void replay_record_seed(replay_log_t* log, uint32_t seed,
+                        uint32_t slot) {
+  log->len = 0;
+  log->last_slot = slot;
+  replay_put(log, REPLAY_EV_SEED << REPLAY_EV_SHIFT);
+  replay_put(log, seed & 0xFF);
+  replay_put(log, (seed >> 8) & 0xFF);
+  replay_put(log, (seed >> 16) & 0xFF);
+  replay_put(log, (seed >> 24) & 0xFF);
+}
+
+/*
+ * Check that a log starts with a seed, and that nothing
+ * has been written over since.
+ */
+uint8_t replay_complete(const replay_log_t* log) {
+  return ((log->len > 0) &&
+          (log->len <= VVC_REPLAY_LOG_SIZE) &&
+          ((log->buf[0] >> REPLAY_EV_SHIFT) == REPLAY_EV_SEED));
+}
+
+/*
+ * Start reading a log from the beginning.
+ */
+void replay_start(replay_reader_t* reader, const replay_log_t* log) {
+  reader->log = log;
+  reader->pos = 0;
+  reader->slot = 0;
+}
+
+/*
+ * Apply the next event in a log to a game. Moves are
+ * checked for collisions just like the buttons do, so they
+ * play out the same way that they did when recorded.
+ */
+uint8_t replay_step(replay_reader_t* reader, tetris_game_t* g) {
+  const replay_log_t* log = reader->log;
+  uint8_t dat;
+  uint8_t ev;
+  int8_t new_r;
+  uint32_t seed;
+  if (reader->pos >= log->len) { return REPLAY_EV_END; }
+  dat = log->buf[reader->pos++];
+  ev = dat >> REPLAY_EV_SHIFT;
+  reader->slot += dat & REPLAY_DELTA_MAX;
+  if (ev == REPLAY_EV_SEED) {
+    if (reader->pos + 4 > log->len) { return REPLAY_EV_END; }
+    seed  = (uint32_t)log->buf[reader->pos++];
+    seed |= (uint32_t)log->buf[reader->pos++] << 8;
+    seed |= (uint32_t)log->buf[reader->pos++] << 16;
+    seed |= (uint32_t)log->buf[reader->pos++] << 24;
+    tetris_new_game_seeded(g, seed);
+  }
+  else if (ev == REPLAY_EV_TICK) {
+    tetris_game_tick(g);
+  }
+  else if (ev == REPLAY_EV_LEFT) {
+    if (!check_brick_pos(g, g->cur.x - 1, g->cur.y)) {
+      g->cur.x -= 1;
+    }
+  }
+  else if (ev == REPLAY_EV_RIGHT) {
+    if (!check_brick_pos(g, g->cur.x + 1, g->cur.y)) {
+      g->cur.x += 1;
+    }
+  }
+  else if (ev == REPLAY_EV_ROT_CW || ev == REPLAY_EV_ROT_CCW) {
+    new_r = (g->cur.r + ((ev == REPLAY_EV_ROT_CW) ? 3 : 1)) % 4;
+    if (!check_brick_rot(g, new_r)) {
+      g->cur.r = new_r;
+    }
+  }
+  else if (ev == REPLAY_EV_DROP) {
+    g->cur.y = tetris_landing_row(g);
+  }
+  return ev;
+}
@@ -0,0 +1,63 @@
+#ifndef _VVC_REPLAY_H
+#define _VVC_REPLAY_H
+
+#include "tetris.h"
+
+// Game recordings, for replaying a game exactly.
+// Rather than raw button presses, the log holds the moves
+// which actually changed the game, in the order that they
+// happened: each new game's brick seed, every gravity tick,
+// and every successful move, rotation and hard drop. Playing
+// those back through the engine reproduces the game.
+// Each event is 1 byte: the event type in the top 3 bits, and
+// the number of frame slots since the previous event in the
+// bottom 5. Longer gaps are filled with 'wait' events, and a
+// 'seed' event is followed by the 4-byte seed. (Little-endian)
+#define REPLAY_EV_WAIT     (0)
+#define REPLAY_EV_TICK     (1)
+#define REPLAY_EV_LEFT     (2)
+#define REPLAY_EV_RIGHT    (3)
+#define REPLAY_EV_ROT_CW   (4)
+#define REPLAY_EV_ROT_CCW  (5)
+#define REPLAY_EV_DROP     (6)
+#define REPLAY_EV_SEED     (7)
+#define REPLAY_EV_END      (0xFF)
+#define REPLAY_EV_SHIFT    (5)
+#define REPLAY_DELTA_MAX   (0x1F)
+
+// Size of the log's ring buffer, in bytes. (A power of 2)
+// Once a game's events fill it, the oldest ones are written
+// over and the game can no longer be replayed.
+#ifndef VVC_REPLAY_LOG_SIZE
+  #define VVC_REPLAY_LOG_SIZE (1024)
+#endif
+#define REPLAY_LOG_MASK (VVC_REPLAY_LOG_SIZE - 1)
+
+typedef struct {
+  // Bytes written since the current game started.
+  uint32_t len;
+  // Frame slot of the last event.
+  uint32_t last_slot;
+  uint8_t buf[VVC_REPLAY_LOG_SIZE];
+} replay_log_t;
+
+typedef struct {
+  const replay_log_t* log;
+  uint32_t pos;
+  // Frame slot of the last event read, counting from 0.
+  uint32_t slot;
+} replay_reader_t;
+
+// Recording. A seed event starts a new recording.
+void replay_record_seed(replay_log_t* log, uint32_t seed,
+                        uint32_t slot);
+void replay_record(replay_log_t* log, uint8_t ev, uint32_t slot);
+// Returns 1 if the log holds a whole game, from its seed.
+uint8_t replay_complete(const replay_log_t* log);
+
+// Playback. Each step applies one event to a game, and
+// returns its type; or 'REPLAY_EV_END' when there are none left.
+void replay_start(replay_reader_t* reader, const replay_log_t* log);
+uint8_t replay_step(replay_reader_t* reader, tetris_game_t* g);
+
+#endif
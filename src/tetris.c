@@ -0,0 +1,363 @@
+#include "tetris.h"
+
+// Game rules: moving, locking and clearing bricks.
+/*
+ * Empty the grid and move the current brick back to its
+ * starting position.
+ */
+void tetris_reset_board(tetris_game_t* g) {
+  uint8_t grid_ix = 0;
+  uint8_t grid_iy = 0;
+  g->cleared_rows = 0;
+  // Reset the 'current block' position.
+  g->cur.x = BRICK_SPAWN_X[g->cur.type];
+  g->cur.y = BRICK_SPAWN_Y[g->cur.type];
+  g->cur.r = 0;
+  // Clear the grid memory.
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+      g->grid[grid_ix][grid_iy] = TGRID_EMPTY;
+    }
+  }
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    g->rows[grid_iy] = 0;
+  }
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    g->heights[grid_ix] = 0;
+  }
+}
+
+/*
+ * Start a new game on an empty grid, and deal the first two
+ * bricks from a freshly seeded brick sequence.
+ */
+void tetris_new_game(tetris_game_t* g) {
+  tetris_new_game_seeded(g, tetris_plat_rng_seed());
+}
+
+/*
+ * Start a new game with a given brick seed, so that an
+ * earlier game's bricks can be dealt again.
+ */
+void tetris_new_game_seeded(tetris_game_t* g, uint32_t seed) {
+  g->score = 0;
+  g->level = 0;
+  g->level_rows = TETRIS_ROWS_PER_LEVEL;
+  g->game_over = 0;
+  g->brick_count = 0;
+  tetris_reset_board(g);
+  tetris_rng_init(&g->rng, seed);
+  tetris_plat_set_speed(0);
+  g->cur.type = tetris_next_brick(&g->rng);
+  g->cur.x = BRICK_SPAWN_X[g->cur.type];
+  g->cur.y = BRICK_SPAWN_Y[g->cur.type];
+  g->cur.r = 0;
+  g->next_type = tetris_next_brick(&g->rng);
+}
+
+/*
+ * Check whether a brick would overlap the walls, the floor,
+ * or any filled cells at a given position. The walls and
+ * floor are checked against the brick's extents; then it
+ * takes one shift and AND per brick row, using the row
+ * bitboards. (Rows above the top of the grid can't hold
+ * any filled cells, so they are skipped.)
+ * Return 1 if there is a collision, 0 if the space is free.
+ */
+static uint8_t tetris_collides(const uint16_t* rows,
+                               uint8_t type, uint8_t rot,
+                               int8_t xp, int8_t yp) {
+  int8_t brick_iy;
+  int8_t grid_iy;
+  uint32_t brick_row;
+  if ((xp + BRICK_LEFT[rot][type] < 0) ||
+      (xp + BRICK_RIGHT[rot][type] > 9) ||
+      (yp + BRICK_BOTTOM[rot][type] > 19)) {
+    return 1;
+  }
+  for (brick_iy = BRICK_TOP[rot][type];
+       brick_iy <= BRICK_BOTTOM[rot][type]; ++brick_iy) {
+    grid_iy = yp + brick_iy;
+    if (grid_iy < 0) { continue; }
+    // (Shift up by 4 bits, since 'xp' can be negative.)
+    brick_row = BRICK_ROWS[rot][type][brick_iy];
+    if ((brick_row << (xp + 4)) &
+        ((uint32_t)rows[grid_iy] << 4)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Recompute the column heights from the row bitboards.
+ * Rows are scanned from the top down, and each column takes
+ * its height from the first row which has it filled.
+ */
+static void tetris_update_heights(tetris_game_t* g) {
+  uint16_t found = 0;
+  uint16_t new_cols;
+  uint8_t grid_ix;
+  uint8_t grid_iy;
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    g->heights[grid_ix] = 0;
+  }
+  for (grid_iy = 0; grid_iy < 20 && found != TROW_FULL; ++grid_iy) {
+    new_cols = g->rows[grid_iy] & ~found;
+    found |= new_cols;
+    for (grid_ix = 0; new_cols; ++grid_ix, new_cols >>= 1) {
+      if (new_cols & 1) { g->heights[grid_ix] = 20 - grid_iy; }
+    }
+  }
+}
+
+/*
+ * Find the row that the current brick would land on if it
+ * was dropped straight down. Each of the brick's (up to 4)
+ * columns can fall until its bottom cell sits on top of
+ * that column's stack, and the brick stops at whichever
+ * limit is reached first.
+ * That only holds if the brick is above the stack; if it
+ * has been slid in under an overhang, step it down instead.
+ */
+int8_t tetris_landing_row(const tetris_game_t* g) {
+  int8_t land_y = 19;
+  int8_t col_y;
+  uint8_t brick_ix;
+  uint8_t col_bottom;
+  for (brick_ix = BRICK_LEFT[g->cur.r][g->cur.type];
+       brick_ix <= BRICK_RIGHT[g->cur.r][g->cur.type]; ++brick_ix) {
+    col_bottom = BRICK_COL_BOTTOM[g->cur.r][g->cur.type][brick_ix];
+    if (col_bottom == BRICK_COL_EMPTY) { continue; }
+    col_y = 19 - g->heights[g->cur.x + brick_ix] - col_bottom;
+    if (col_y < land_y) { land_y = col_y; }
+  }
+  if (land_y < g->cur.y) {
+    land_y = g->cur.y;
+    while (!check_brick_pos(g, g->cur.x, land_y + 1)) { ++land_y; }
+  }
+  return land_y;
+}
+
+/*
+ * Check whether the current brick can rotate into a given
+ * position. Return 1 if there is a collision, 0 if it can rotate.
+ */
+uint8_t check_brick_rot(const tetris_game_t* g, int8_t new_r) {
+  return tetris_collides(g->rows, g->cur.type, new_r,
+                         g->cur.x, g->cur.y);
+}
+
+/*
+ * Check whether the current brick can move into a
+ * given grid coordinate.
+ * Return 1 if there is a collision, 0 if the space is free.
+ */
+uint8_t check_brick_pos(const tetris_game_t* g, int8_t xp, int8_t yp) {
+  return tetris_collides(g->rows, g->cur.type, g->cur.r, xp, yp);
+}
+
+/*
+ * Remove every full row from the tetris grid in one pass.
+ * Rows are walked from the bottom up; each row which is not
+ * full is moved straight to its final position, and the rows
+ * left over at the top are emptied. Rows below the lowest
+ * full row don't move, so the pass starts there.
+ * Sets 'cleared_mask' to the full rows (bit N = row N, before
+ * moving) and returns how many there were.
+ */
+uint8_t tetris_compact_rows(tetris_game_t* g, uint32_t* cleared_mask) {
+  int8_t src_iy = 19;
+  int8_t dst_iy;
+  uint8_t grid_ix;
+  *cleared_mask = 0;
+  while (src_iy >= 0 && g->rows[src_iy] != TROW_FULL) {
+    --src_iy;
+  }
+  for (dst_iy = src_iy; src_iy >= 0; --src_iy) {
+    if (g->rows[src_iy] == TROW_FULL) {
+      *cleared_mask |= (1UL << src_iy);
+      continue;
+    }
+    if (dst_iy != src_iy) {
+      for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+        g->grid[grid_ix][dst_iy] = g->grid[grid_ix][src_iy];
+      }
+      g->rows[dst_iy] = g->rows[src_iy];
+    }
+    --dst_iy;
+  }
+  // Empty the rows at the top which were uncovered.
+  for (; dst_iy >= 0; --dst_iy) {
+    for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+      g->grid[grid_ix][dst_iy] = TGRID_EMPTY;
+    }
+    g->rows[dst_iy] = 0;
+  }
+  // (Count the cleared rows; there are at most 4.)
+  uint32_t mask = *cleared_mask;
+  uint8_t num_rows = 0;
+  while (mask) {
+    mask &= mask - 1;
+    ++num_rows;
+  }
+  return num_rows;
+}
+
+/*
+ * Restart the brick randomizer from a given seed.
+ * The first draw after this shuffles a fresh bag.
+ */
+void tetris_rng_init(tetris_rng_t* rng, uint32_t seed) {
+  rng->seed = seed;
+  if (!seed) { seed = TETRIS_RNG_ZERO_SEED; }
+  rng->state = seed;
+  rng->bag_pos = 7;
+}
+
+/*
+ * Step the 32-bit xorshift generator.
+ */
+static uint32_t tetris_rng_next(tetris_rng_t* rng) {
+  uint32_t x = rng->state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rng->state = x;
+  return x;
+}
+
+/*
+ * Draw the next brick type from the bag, refilling it with
+ * a new shuffle when it runs out. The shuffle picks each
+ * swap index by scaling 16 random bits, which avoids a
+ * division. (The Cortex-M0 has no hardware divider.)
+ */
+uint8_t tetris_next_brick(tetris_rng_t* rng) {
+  uint8_t bag_i;
+  uint8_t swap_i;
+  uint8_t swap;
+  if (rng->bag_pos >= 7) {
+    for (bag_i = 0; bag_i < 7; ++bag_i) {
+      rng->bag[bag_i] = bag_i;
+    }
+    for (bag_i = 6; bag_i > 0; --bag_i) {
+      swap_i = ((tetris_rng_next(rng) >> 16) * (bag_i + 1)) >> 16;
+      swap = rng->bag[bag_i];
+      rng->bag[bag_i] = rng->bag[swap_i];
+      rng->bag[swap_i] = swap;
+    }
+    rng->bag_pos = 0;
+  }
+  return rng->bag[rng->bag_pos++];
+}
+
+/*
+ * Main 'tick' for the Tetris game loop.
+ * This performs one 'step' in the game, either dropping a brick
+ * or setting it in place and clearing rows/creating the next one.
+ */
+void tetris_game_tick(tetris_game_t* g) {
+  int8_t grid_ix = 0;
+  int8_t grid_iy = 0;
+  unsigned char can_drop = 1;
+  uint8_t game_over = 0;
+  /* Step 1:  Try to drop the current brick by 1 cell. */
+  if (check_brick_pos(g, g->cur.x, g->cur.y+1)) {
+    can_drop = 0;
+  }
+
+  if (can_drop) {
+    /* Step 2a: If the current brick can drop, do so. */
+    g->cur.y++;
+  }
+  else {
+    /* Step 2b: If the current brick cannot drop, fix it
+     *          in the main Tetris grid. */
+    uint8_t cell_i;
+    for (cell_i = 0; cell_i < 4; ++cell_i) {
+      grid_ix = g->cur.x +
+        BRICK_CELL_X(BRICK_CELLS[g->cur.r][g->cur.type][cell_i]);
+      grid_iy = g->cur.y +
+        BRICK_CELL_Y(BRICK_CELLS[g->cur.r][g->cur.type][cell_i]);
+      if (grid_iy < 0) {
+        // Game over
+        game_over = 1;
+      }
+      else {
+        g->grid[grid_ix][grid_iy] = g->cur.type;
+        g->rows[grid_iy] |= (1 << grid_ix);
+        if (g->heights[grid_ix] < 20 - grid_iy) {
+          g->heights[grid_ix] = 20 - grid_iy;
+        }
+      }
+    }
+    if (game_over) {
+      g->game_over = 1;
+      tetris_plat_game_over();
+    }
+
+    /* Step 3b: Clear any full rows. */
+    uint32_t cleared_mask;
+    uint8_t rows_cleared = tetris_compact_rows(g, &cleared_mask);
+    if (rows_cleared) {
+      tetris_update_heights(g);
+      // Score 1 point per row, and go up a level every
+      // 'TETRIS_ROWS_PER_LEVEL' rows. (At most 4 rows clear at
+      // once, so that's at most one level.)
+      g->score = tetris_bcd_add(g->score, rows_cleared);
+      if (g->level < TETRIS_LEVEL_MAX) {
+        if (rows_cleared >= g->level_rows) {
+          g->level_rows += TETRIS_ROWS_PER_LEVEL;
+          g->level = tetris_bcd_add(g->level, 1);
+          // When the level increments, make the game's main
+          // 'tick' faster.
+          tetris_plat_set_speed(tetris_bcd_value(g->level));
+        }
+        g->level_rows -= rows_cleared;
+      }
+      if (g->cleared_rows) {
+        g->cleared_rows = TETRIS_ROWS_UNKNOWN;
+      }
+      else {
+        g->cleared_rows = cleared_mask;
+      }
+    }
+
+    /* Step 4b: Create a new 'current brick'. */
+    g->cur.type = g->next_type;
+    g->next_type = tetris_next_brick(&g->rng);
+    g->cur.x = BRICK_SPAWN_X[g->cur.type];
+    g->cur.y = BRICK_SPAWN_Y[g->cur.type];
+    g->cur.r = 0;
+    ++g->brick_count;
+  }
+}
+
+/*
+ * Add two packed BCD numbers, of up to 7 digits. Each digit
+ * has 6 added to it first, so that a digit which goes past 9
+ * carries into the next one like a binary digit would; then
+ * the 6 is taken back off of the digits which didn't carry.
+ * (A carry out of a digit leaves its low bit in the next
+ * digit's sum different from the XOR of the two inputs.)
+ */
+uint32_t tetris_bcd_add(uint32_t bcd, uint32_t add) {
+  uint32_t biased = bcd + 0x06666666;
+  uint32_t sum = biased + add;
+  uint32_t no_carry = ~(sum ^ biased ^ add) & 0x11111110;
+  return sum - ((no_carry >> 2) | (no_carry >> 3));
+}
+
+/*
+ * Get the value of a packed BCD number. (Not for use in every
+ * frame; it takes a multiply per digit.)
+ */
+uint32_t tetris_bcd_value(uint32_t bcd) {
+  uint32_t value = 0;
+  int8_t shift;
+  for (shift = 28; shift >= 0; shift -= 4) {
+    value = (value * 10) + ((bcd >> shift) & 0xF);
+  }
+  return value;
+}
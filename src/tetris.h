@@ -0,0 +1,165 @@
+#ifndef _VVC_TETRIS_H
+#define _VVC_TETRIS_H
+
+// The game rules, kept apart from the display and the timers
+// so that they can also be built and run on a host machine.
+// Anything which needs the hardware goes through the
+// 'platform interface' at the bottom of this file.
+
+#include <stdint.h>
+
+// ----------------------
+// Game constants.
+// Macro definitions for the Tetris grid/bricks.
+// (Note: The brick values should not be changed; the
+//  'BRICKS' const array relies on them. [TODO])
+#define TGRID_I       (0)
+#define TGRID_O       (1)
+#define TGRID_L       (2)
+#define TGRID_J       (3)
+#define TGRID_T       (4)
+#define TGRID_Z       (5)
+#define TGRID_S       (6)
+#define TGRID_EMPTY   (7)
+#define TGRID_CURRENT (8)
+#define TBRICK_I      TGRID_I
+#define TBRICK_O      TGRID_O
+#define TBRICK_L      TGRID_L
+#define TBRICK_J      TGRID_J
+#define TBRICK_T      TGRID_T
+#define TBRICK_Z      TGRID_Z
+#define TBRICK_S      TGRID_S
+// Define X/Y boundaries for each brick. Based on a 4x4 grid,
+// with the 'center of rotation' at (1,1).
+// Indices: [ rotation ], [ brick type ].
+// The uint16 value has the 4x4 grid, with each hex digit
+// representing a row. Most-Significant Bit = top rows.
+// (Try drawing them out - it helps.)
+static const uint16_t BRICKS[4][7] = {
+  // Ordering is 'I', 'O', 'L', 'J', 'T', 'Z', 'S'.
+  // 'Rotated by 0   degrees'
+  { 0x4444, 0x0660, 0xC440, 0x6440, 0x4E00, 0x4C80, 0x8C40 },
+  // 'Rotated by 90  degrees'
+  { 0x0F00, 0x0660, 0x2E00, 0x0E20, 0x4640, 0xC600, 0x6C00 },
+  // 'Rotated by 180 degrees'
+  { 0x2222, 0x0660, 0x4460, 0x44C0, 0x0E40, 0x2640, 0x4620 },
+  // 'Rotated by 270 degrees'
+  { 0x00F0, 0x0660, 0x0E80, 0x8E00, 0x4C40, 0x0C60, 0x06C0 }
+};
+// Packed (x, y) cell coordinates, used in 'BRICK_CELLS'.
+#define BRICK_CELL(x, y)  ((x) | ((y) << 4))
+#define BRICK_CELL_X(c)   ((c) & 0x0F)
+#define BRICK_CELL_Y(c)   ((c) >> 4)
+// Marks columns of a brick's 4x4 grid which are empty.
+#define BRICK_COL_EMPTY   (0xFF)
+// Row masks, extents, cell lists and spawn positions for
+// each brick, generated from 'BRICKS'. (tools/gen_bricks.c)
+#include "bricks.h"
+// A full row, in the 'rows' bitboards.
+#define TROW_FULL  (0x3FF)
+// 'cleared_rows' value for when more rows were cleared
+// before the renderer caught up. (See below)
+#define TETRIS_ROWS_UNKNOWN (1UL << 31)
+// (xorshift can't start from 0, so that seed is replaced.)
+#define TETRIS_RNG_ZERO_SEED (0x2545F491)
+// Rows to clear for each level, and the top level. (In BCD)
+#define TETRIS_ROWS_PER_LEVEL (5)
+#define TETRIS_LEVEL_MAX      (0x20)
+
+// ----------------------
+// Game state.
+// Brick randomizer: a 'bag' holding one of each of the 7 bricks
+// in a shuffled order, which is refilled once it is used up.
+// The shuffles come from a 32-bit xorshift generator, so the
+// whole sequence of bricks can be replayed from 'seed', or
+// picked up mid-game from a copy of this struct.
+typedef struct {
+  uint32_t seed;
+  uint32_t state;
+  uint8_t bag[7];
+  uint8_t bag_pos;
+} tetris_rng_t;
+// A brick's type, position and rotation.
+typedef struct {
+  uint8_t type;
+  int8_t x;
+  int8_t y;
+  int8_t r;
+} tetris_piece_t;
+// Everything about one game. The engine methods all take the
+// game that they work on, so there can be more than one; e.g.
+// for trying moves out on a copy.
+// On the board, the button interrupts move 'cur' while the
+// main loop ticks the game and draws it, so the main loop
+// ticks with interrupts masked and draws from a snapshot of
+// 'cur'. Nothing here needs to be 'volatile'.
+typedef struct {
+  // The Tetris grid; use a full byte per pixel. It's a
+  // bit profligate, but we'll want to store color
+  // in the V2 board and it'll make the math simple.
+  uint8_t grid[10][20];
+  // Which cells of each grid row are filled; bit N = column N.
+  // This is kept in sync with 'grid', which only needs to be
+  // read for the cells' colors.
+  uint16_t rows[20];
+  // How tall the stack is in each column: 20 minus the
+  // top-most filled row, or 0 if the column is empty. Raised
+  // when a brick is locked, and recomputed from 'rows' after
+  // a clear.
+  uint8_t heights[10];
+  // The current brick, and the type of the next one.
+  tetris_piece_t cur;
+  uint8_t next_type;
+  // The score (1 point per cleared row) and level, in packed
+  // BCD: one decimal digit per 4 bits, lowest digit first.
+  // They're only ever counted up, so the display can draw
+  // them a digit at a time without dividing. (The Cortex-M0
+  // has no divide instruction.)
+  uint32_t score;
+  uint8_t level;
+  // Rows still to clear before the next level.
+  uint8_t level_rows;
+  // Set once a brick has locked above the top of the grid.
+  uint8_t game_over;
+  // Bitmask of the rows (bit N = row N, before shifting) which
+  // the last brick to lock in place cleared. The renderer uses
+  // it to shift the playfield on the display, and resets it.
+  // If more rows clear before it is drawn, it is 'unknown'.
+  uint32_t cleared_rows;
+  // How many bricks have been dealt since the game started.
+  uint32_t brick_count;
+  tetris_rng_t rng;
+} tetris_game_t;
+
+// ----------------------
+// Engine methods.
+void tetris_reset_board(tetris_game_t* g);
+void tetris_new_game(tetris_game_t* g);
+void tetris_new_game_seeded(tetris_game_t* g, uint32_t seed);
+uint8_t check_brick_rot(const tetris_game_t* g, int8_t new_r);
+uint8_t check_brick_pos(const tetris_game_t* g, int8_t xp, int8_t yp);
+int8_t tetris_landing_row(const tetris_game_t* g);
+uint8_t tetris_compact_rows(tetris_game_t* g, uint32_t* cleared_mask);
+void tetris_rng_init(tetris_rng_t* rng, uint32_t seed);
+uint8_t tetris_next_brick(tetris_rng_t* rng);
+void tetris_game_tick(tetris_game_t* g);
+// Add two packed BCD numbers, or get the value of one.
+// (The score's value is also the number of rows cleared.)
+uint32_t tetris_bcd_add(uint32_t bcd, uint32_t add);
+uint32_t tetris_bcd_value(uint32_t bcd);
+
+// ----------------------
+// Platform interface. The engine calls these, and each build
+// provides them: 'src/tetris_plat.c' on the board, and the
+// host tools on a PC.
+// Return a seed for a new game's brick sequence.
+uint32_t tetris_plat_rng_seed(void);
+// Set the gravity for a level; called when a game starts and
+// when it goes up a level. (The level is passed as a plain
+// number, not in BCD.)
+void tetris_plat_set_speed(uint8_t level);
+// A brick locked above the top of the grid; stop the game.
+// (The game's 'game_over' flag is set, too.)
+void tetris_plat_game_over(void);
+
+#endif
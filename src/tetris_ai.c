@@ -0,0 +1,273 @@
+#include "tetris_ai.h"
+
+// Number of set bits in each 4-bit value.
+static const uint8_t AI_BITS4[16] = {
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/*
+ * Drop a brick straight down onto a grid, and write out the
+ * grid that it leaves behind with any full rows removed.
+ * The landing row comes from the column heights, like
+ * 'tetris_landing_row'.
+ * Returns 0 if the brick would stick out of the top of the
+ * grid (which ends the game), or 1 with 'lines' set to the
+ * number of rows that it cleared and 'y' to where it landed.
+ */
+static uint8_t ai_place(const uint16_t* rows_in,
+                        const uint8_t* heights_in,
+                        uint16_t* rows_out,
+                        uint8_t type, int8_t r, int8_t x,
+                        uint8_t* lines, int8_t* y) {
+  int8_t land_y = 19;
+  int8_t col_y;
+  int8_t src_iy;
+  int8_t dst_iy;
+  uint8_t brick_ix;
+  uint8_t brick_iy;
+  uint8_t col_bottom;
+  for (brick_ix = BRICK_LEFT[r][type];
+       brick_ix <= BRICK_RIGHT[r][type]; ++brick_ix) {
+    col_bottom = BRICK_COL_BOTTOM[r][type][brick_ix];
+    if (col_bottom == BRICK_COL_EMPTY) { continue; }
+    col_y = 19 - heights_in[x + brick_ix] - col_bottom;
+    if (col_y < land_y) { land_y = col_y; }
+  }
+  if (land_y + BRICK_TOP[r][type] < 0) { return 0; }
+  *y = land_y;
+  for (src_iy = 0; src_iy < 20; ++src_iy) {
+    rows_out[src_iy] = rows_in[src_iy];
+  }
+  for (brick_iy = BRICK_TOP[r][type];
+       brick_iy <= BRICK_BOTTOM[r][type]; ++brick_iy) {
+    rows_out[land_y + brick_iy] |=
+      (uint16_t)(BRICK_ROWS[r][type][brick_iy] << (x + 4)) >> 4;
+  }
+  // Remove full rows, in one pass from the bottom up.
+  *lines = 0;
+  for (src_iy = dst_iy = 19; src_iy >= 0; --src_iy) {
+    if (rows_out[src_iy] == TROW_FULL) {
+      ++(*lines);
+      continue;
+    }
+    rows_out[dst_iy--] = rows_out[src_iy];
+  }
+  for (; dst_iy >= 0; --dst_iy) {
+    rows_out[dst_iy] = 0;
+  }
+  return 1;
+}
+
+/*
+ * Score a grid, and work out its column heights.
+ * Scanning from the top down, a column's height is set by
+ * the first row that has it filled, and every empty cell
+ * in a column which has already been 'covered' is a hole.
+ */
+static int32_t ai_eval(const uint16_t* rows, uint8_t* heights,
+                       uint8_t lines) {
+  uint16_t covered = 0;
+  uint16_t cells;
+  uint16_t new_cols;
+  uint8_t grid_ix;
+  uint8_t grid_iy;
+  int16_t total_height = 0;
+  int16_t holes = 0;
+  int16_t bumps = 0;
+  int8_t diff;
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    heights[grid_ix] = 0;
+  }
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    new_cols = rows[grid_iy] & ~covered;
+    for (grid_ix = 0; new_cols; ++grid_ix, new_cols >>= 1) {
+      if (new_cols & 1) {
+        heights[grid_ix] = 20 - grid_iy;
+        total_height += 20 - grid_iy;
+      }
+    }
+    covered |= rows[grid_iy];
+    cells = covered & ~rows[grid_iy];
+    holes += AI_BITS4[cells & 0xF] +
+             AI_BITS4[(cells >> 4) & 0xF] +
+             AI_BITS4[cells >> 8];
+  }
+  for (grid_ix = 0; grid_ix < 9; ++grid_ix) {
+    diff = heights[grid_ix] - heights[grid_ix + 1];
+    bumps += (diff < 0) ? -diff : diff;
+  }
+  return ((int32_t)AI_W_LINES * lines) -
+         ((int32_t)AI_W_HEIGHT * total_height) -
+         ((int32_t)AI_W_HOLES * holes) -
+         ((int32_t)AI_W_BUMPY * bumps);
+}
+
+/*
+ * Move on to the next rotation / column for a brick.
+ * Returns 0 once every one has been tried.
+ */
+static uint8_t ai_next_move(uint8_t type, int8_t* r, int8_t* x) {
+  ++(*x);
+  if (*x > 9 - BRICK_RIGHT[*r][type]) {
+    ++(*r);
+    if (*r > 3) { return 0; }
+    *x = -BRICK_LEFT[*r][type];
+  }
+  return 1;
+}
+
+#ifdef VVC_AI_LOOKAHEAD
+/*
+ * Score a grid left by the second brick, not counting its
+ * cleared rows; from the transposition table if it's there.
+ */
+static int32_t ai_eval_second(tetris_ai_t* ai, const uint16_t* rows,
+                              uint8_t lines, int8_t y) {
+  uint8_t heights[10];
+  uint32_t key;
+  int16_t cached;
+  int32_t score;
+  if (ai->tt) {
+    key = tetris_tt_key(lines ? tetris_tt_hash_rows(rows) :
+                        tetris_tt_hash_brick(ai->hash1, ai->next_type,
+                                             ai->r2, ai->x2, y),
+                        TT_NO_BRICK);
+    if (tetris_tt_probe(ai->tt, key, &cached)) { return cached; }
+    score = ai_eval(rows, heights, 0);
+    tetris_tt_store(ai->tt, key, score, 0);
+  }
+  else {
+    score = ai_eval(rows, heights, 0);
+  }
+  ++ai->evals;
+  return score;
+}
+
+/*
+ * Score the current placement of the first brick, given the
+ * best score that the second brick got on the grid it left.
+ */
+static void ai_score_first(tetris_ai_t* ai, int32_t best2) {
+  int32_t score;
+  if (best2 == AI_SCORE_NONE) { return; }
+  score = best2 + ((int32_t)AI_W_LINES * ai->lines1);
+  if (score > ai->best_score) {
+    ai->best_score = score;
+    ai->best_r = ai->r;
+    ai->best_x = ai->x;
+  }
+}
+
+/*
+ * Hash the grid left by the first brick, and look it up.
+ * Returns 1 if its placement was scored from the table, so
+ * the second brick doesn't need to be tried on it.
+ */
+static uint8_t ai_probe_first(tetris_ai_t* ai, int8_t y) {
+  int16_t cached;
+  if (!ai->tt) { return 0; }
+  ai->hash1 = ai->lines1 ? tetris_tt_hash_rows(ai->rows1) :
+              tetris_tt_hash_brick(ai->hash, ai->type, ai->r, ai->x, y);
+  if (!tetris_tt_probe(ai->tt, tetris_tt_key(ai->hash1, ai->next_type),
+                       &cached)) {
+    return 0;
+  }
+  ai_score_first(ai, (cached == TT_SCORE_NONE) ? AI_SCORE_NONE : cached);
+  return 1;
+}
+#endif
+
+/*
+ * Start searching for a place to put a brick on a grid.
+ */
+void tetris_ai_start(tetris_ai_t* ai, const uint16_t* rows,
+                     uint8_t type, uint8_t next_type) {
+  uint8_t grid_iy;
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    ai->rows[grid_iy] = rows[grid_iy];
+  }
+  ai_eval(ai->rows, ai->heights, 0);
+  ai->type = type;
+  ai->r = 0;
+  ai->x = -BRICK_LEFT[0][type];
+#ifdef VVC_AI_LOOKAHEAD
+  ai->next_type = next_type;
+  ai->have_first = 0;
+  if (ai->tt) {
+    tetris_tt_new_search(ai->tt);
+    ai->hash = tetris_tt_hash_rows(ai->rows);
+  }
+#else
+  (void)next_type;
+#endif
+  // (If nothing fits, just drop it where it is.)
+  ai->best_score = AI_SCORE_NONE;
+  ai->best_r = 0;
+  ai->best_x = BRICK_SPAWN_X[type];
+  ai->done = 0;
+}
+
+/*
+ * Try one more placement.
+ * Returns 1 once the search is done.
+ */
+uint8_t tetris_ai_step(tetris_ai_t* ai) {
+  uint16_t rows[20];
+  uint8_t lines;
+  int8_t y;
+  int32_t score;
+#ifndef VVC_AI_LOOKAHEAD
+  uint8_t heights[10];
+#endif
+  if (ai->done) { return 1; }
+#ifdef VVC_AI_LOOKAHEAD
+  if (!ai->have_first) {
+    // Place the first brick; its placements are scored by
+    // the best that the second brick can do afterwards.
+    // (Scores are kept without the rows cleared before them,
+    // so that they only depend on the grid.)
+    if (ai_place(ai->rows, ai->heights, ai->rows1,
+                 ai->type, ai->r, ai->x, &ai->lines1, &y)) {
+      if (!ai_probe_first(ai, y)) {
+        ai_eval(ai->rows1, ai->heights1, 0);
+        ai->have_first = 1;
+        ai->best2 = AI_SCORE_NONE;
+        ai->r2 = 0;
+        ai->x2 = -BRICK_LEFT[0][ai->next_type];
+        return 0;
+      }
+    }
+  }
+  else {
+    if (ai_place(ai->rows1, ai->heights1, rows,
+                 ai->next_type, ai->r2, ai->x2, &lines, &y)) {
+      score = ai_eval_second(ai, rows, lines, y) +
+              ((int32_t)AI_W_LINES * lines);
+      if (score > ai->best2) { ai->best2 = score; }
+    }
+    if (ai_next_move(ai->next_type, &ai->r2, &ai->x2)) { return 0; }
+    ai->have_first = 0;
+    if (ai->tt) {
+      tetris_tt_store(ai->tt, tetris_tt_key(ai->hash1, ai->next_type),
+                      (ai->best2 == AI_SCORE_NONE) ?
+                      TT_SCORE_NONE : ai->best2, 1);
+    }
+    ai_score_first(ai, ai->best2);
+  }
+#else
+  if (ai_place(ai->rows, ai->heights, rows,
+               ai->type, ai->r, ai->x, &lines, &y)) {
+    score = ai_eval(rows, heights, lines);
+    ++ai->evals;
+    if (score > ai->best_score) {
+      ai->best_score = score;
+      ai->best_r = ai->r;
+      ai->best_x = ai->x;
+    }
+  }
+#endif
+  if (!ai_next_move(ai->type, &ai->r, &ai->x)) {
+    ai->done = 1;
+  }
+  return ai->done;
+}
@@ -0,0 +1,72 @@
+#ifndef _VVC_TETRIS_AI_H
+#define _VVC_TETRIS_AI_H
+
+#include "tetris.h"
+#include "tetris_tt.h"
+
+// A simple computer player. It tries dropping the brick
+// straight down from every rotation and column, and scores
+// the grid that each drop would leave behind. With
+// 'VVC_AI_LOOKAHEAD', every placement of the next brick is
+// also tried on top of each one. ('make AI_LOOKAHEAD=1')
+// The search runs one placement per call to 'tetris_ai_step',
+// so that the caller decides how much time it gets.
+// The lookahead can remember the grids it has already scored
+// in a transposition table, and skip them when they come up
+// again. (See src/tetris_tt.h)
+
+// Heuristic weights: points per cleared row, and penalties
+// for the total column height, covered empty cells ('holes'),
+// and height differences between neighboring columns.
+#define AI_W_LINES  (76)
+#define AI_W_HEIGHT (51)
+#define AI_W_HOLES  (36)
+#define AI_W_BUMPY  (18)
+// Score given before any placement has been tried.
+#define AI_SCORE_NONE (-0x7FFFFFFF)
+
+typedef struct {
+  // The grid being searched from, and its column heights.
+  uint16_t rows[20];
+  uint8_t heights[10];
+  uint8_t type;
+  // The next placement to try.
+  int8_t r;
+  int8_t x;
+#ifdef VVC_AI_LOOKAHEAD
+  // The grid after the current placement of the first brick,
+  // and the next placement of the second brick to try on it.
+  uint16_t rows1[20];
+  uint8_t heights1[10];
+  uint8_t lines1;
+  uint8_t have_first;
+  uint8_t next_type;
+  int8_t r2;
+  int8_t x2;
+  // Best score for the second brick on 'rows1' so far.
+  int32_t best2;
+  // Transposition table to use, or NULL for none. (Set by the
+  // caller; it's kept between searches.) With one, the hashes
+  // of 'rows' and 'rows1'.
+  tetris_tt_t* tt;
+  uint32_t hash;
+  uint32_t hash1;
+#endif
+  // Best placement found so far.
+  int32_t best_score;
+  int8_t best_r;
+  int8_t best_x;
+  uint8_t done;
+  // Number of grids scored, over every search.
+  uint32_t evals;
+} tetris_ai_t;
+
+// Start searching for a place to put a brick on a grid.
+// ('next_type' is only used with 'VVC_AI_LOOKAHEAD')
+void tetris_ai_start(tetris_ai_t* ai, const uint16_t* rows,
+                     uint8_t type, uint8_t next_type);
+// Try one more placement. Returns 1 once the search is done;
+// the result is in 'best_r' / 'best_x'.
+uint8_t tetris_ai_step(tetris_ai_t* ai);
+
+#endif
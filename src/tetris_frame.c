@@ -0,0 +1,71 @@
+#include "tetris_frame.h"
+
+/*
+ * Start a new game's timing, at a level's speed.
+ */
+void tetris_frame_reset(tetris_frame_t* f, uint8_t level) {
+  f->gravity = GRAVITY_CURVE[level];
+  f->gravity_acc = 0;
+  f->lock_frames = 0;
+  f->shift_frames = 0;
+}
+
+/*
+ * Run one frame slot of a game's timing.
+ * Holding 'Left' / 'Right' repeats the move; the first one
+ * happened when the button was pressed, so the repeats start
+ * after 'SHIFT_DELAY_FRAMES' and then come every
+ * 'SHIFT_REPEAT_FRAMES'. Holding 'Down' raises the gravity.
+ * The gravity is added to 'gravity_acc', and the brick drops
+ * a row for each whole row in it. Once it can't drop any
+ * further it waits 'LOCK_DELAY_FRAMES' before locking, so it
+ * can still be slid off of a ledge; the gravity doesn't build
+ * up while it waits.
+ */
+void tetris_frame_step(tetris_frame_t* f, tetris_game_t* g,
+                       uint8_t held) {
+  uint32_t frame_gravity = f->gravity;
+  if ((held & TFRAME_HELD_DOWN) && (frame_gravity < SOFT_DROP_GRAVITY)) {
+    frame_gravity = SOFT_DROP_GRAVITY;
+  }
+  if (held & (TFRAME_HELD_LEFT | TFRAME_HELD_RIGHT)) {
+    if (++f->shift_frames >= SHIFT_DELAY_FRAMES) {
+      f->shift_frames = SHIFT_DELAY_FRAMES - SHIFT_REPEAT_FRAMES;
+      if ((held & TFRAME_HELD_RIGHT) &&
+          !check_brick_pos(g, g->cur.x + 1, g->cur.y)) {
+        g->cur.x += 1;
+        tetris_plat_frame_event(TFRAME_EV_RIGHT);
+      }
+      if ((held & TFRAME_HELD_LEFT) &&
+          !check_brick_pos(g, g->cur.x - 1, g->cur.y)) {
+        g->cur.x -= 1;
+        tetris_plat_frame_event(TFRAME_EV_LEFT);
+      }
+    }
+  }
+  else {
+    f->shift_frames = 0;
+  }
+  f->gravity_acc += frame_gravity;
+  while ((f->gravity_acc >= GRAVITY_ONE) && !g->game_over) {
+    if (check_brick_pos(g, g->cur.x, g->cur.y + 1)) { break; }
+    f->gravity_acc -= GRAVITY_ONE;
+    f->lock_frames = 0;
+    tetris_plat_frame_event(TFRAME_EV_DROP);
+    tetris_game_tick(g);
+  }
+  if (g->game_over) {
+    f->gravity_acc = 0;
+  }
+  else if (check_brick_pos(g, g->cur.x, g->cur.y + 1)) {
+    f->gravity_acc = 0;
+    if (++f->lock_frames >= LOCK_DELAY_FRAMES) {
+      f->lock_frames = 0;
+      tetris_plat_frame_event(TFRAME_EV_LOCK);
+      tetris_game_tick(g);
+    }
+  }
+  else {
+    f->lock_frames = 0;
+  }
+}
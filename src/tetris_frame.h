@@ -0,0 +1,83 @@
+#ifndef _VVC_TETRIS_FRAME_H
+#define _VVC_TETRIS_FRAME_H
+
+#include "tetris.h"
+
+// The game's timing, counted in display frame slots: once per
+// slot, 'tetris_frame_step' adds the level's gravity to an
+// accumulator and moves the brick down one row for each whole
+// row in it. The gravity is in rows per slot, with 16
+// fractional bits, so it can be anything from a row every few
+// seconds to several rows per slot. (Given here in rows per
+// second, times 100.) It doesn't touch any hardware; the board
+// runs it from 'game_frame', and 'make check-frame' runs it on
+// a PC. (See tools/check_frame.c)
+#ifndef VVC_FRAME_HZ
+  #define VVC_FRAME_HZ (30)
+#endif
+#define GRAVITY_ONE           (1UL << 16)
+#define GRAVITY_RPS(rps_x100) \
+  ((uint32_t)(((uint64_t)(rps_x100) * GRAVITY_ONE) / (100 * VVC_FRAME_HZ)))
+// Frame slots in a number of milliseconds. (At least 1)
+#define FRAMES_MS(ms) \
+  ((((ms) * VVC_FRAME_HZ) >= 1000) ? (((ms) * VVC_FRAME_HZ) / 1000) : 1)
+// The speed curve: gravity at each level, 0 to 20. It starts
+// at a row per second, and climbs slowly to about 3 by level
+// 10; past that it speeds up to 20 rows per second, and then
+// to dropping straight down. ('TETRIS_LEVEL_MAX')
+static const uint32_t GRAVITY_CURVE[21] = {
+  GRAVITY_RPS(100),   GRAVITY_RPS(107),   GRAVITY_RPS(115),
+  GRAVITY_RPS(124),   GRAVITY_RPS(135),   GRAVITY_RPS(149),
+  GRAVITY_RPS(165),   GRAVITY_RPS(185),   GRAVITY_RPS(212),
+  GRAVITY_RPS(248),   GRAVITY_RPS(292),   GRAVITY_RPS(350),
+  GRAVITY_RPS(420),   GRAVITY_RPS(500),   GRAVITY_RPS(600),
+  GRAVITY_RPS(750),   GRAVITY_RPS(1000),  GRAVITY_RPS(1400),
+  GRAVITY_RPS(2000),  GRAVITY_RPS(6000),  GRAVITY_RPS(60000)
+};
+// Holding 'Down' raises the gravity to at least this.
+#define SOFT_DROP_GRAVITY     GRAVITY_RPS(650)
+// How long a brick can rest on the stack before it locks.
+// (Pressing 'Down' on a brick which has landed doesn't lock
+//  it any sooner; a hard drop does lock it at once.)
+#define LOCK_DELAY_FRAMES     FRAMES_MS(500)
+// Holding 'Left' or 'Right' repeats the move after a delay,
+// and then at a steady rate.
+#define SHIFT_DELAY_FRAMES    FRAMES_MS(460)
+#define SHIFT_REPEAT_FRAMES   FRAMES_MS(150)
+
+// Buttons held down during a frame slot.
+#define TFRAME_HELD_DOWN   (0x01)
+#define TFRAME_HELD_LEFT   (0x02)
+#define TFRAME_HELD_RIGHT  (0x04)
+
+// Things that 'tetris_frame_step' does, as it does them.
+// (Passed to 'tetris_plat_frame_event'; a drop or a lock is
+//  passed just before the game tick which does it.)
+#define TFRAME_EV_RIGHT    (0)
+#define TFRAME_EV_LEFT     (1)
+#define TFRAME_EV_DROP     (2)
+#define TFRAME_EV_LOCK     (3)
+
+typedef struct {
+  // The current level's entry in 'GRAVITY_CURVE', and the part
+  // of a row that it has built up.
+  uint32_t gravity;
+  uint32_t gravity_acc;
+  // How long the brick has been resting, and how long 'Left' /
+  // 'Right' have been held.
+  uint8_t lock_frames;
+  uint8_t shift_frames;
+} tetris_frame_t;
+
+// Start a new game's timing, at a level's speed.
+void tetris_frame_reset(tetris_frame_t* f, uint8_t level);
+// Run one frame slot of a game's timing: auto-repeat, then
+// gravity, then the lock delay.
+void tetris_frame_step(tetris_frame_t* f, tetris_game_t* g,
+                       uint8_t held);
+
+// Platform interface: each build which runs the timing
+// provides this, like the engine's. ('src/tetris.h')
+void tetris_plat_frame_event(uint8_t ev);
+
+#endif
@@ -0,0 +1,151 @@
+#include "tetris_moves.h"
+
+// The walls on either side of the grid, in a row mask which
+// has the grid's columns at bits 3-12.
+#define TMOVES_WALLS  (0xE007)
+// Bits for every column that a brick's 'x' can be.
+#define TMOVES_X_MASK (0x1FFF)
+
+/*
+ * Work out which columns a brick fits in at one row.
+ * 'walls' holds each grid row's cells shifted up by 3, with
+ * the walls set on either side of them; so for each filled
+ * cell of the brick, shifting the rows it covers down by the
+ * cell's column leaves a bit set wherever it would collide.
+ * Returns the mask of columns where it fits.
+ */
+static uint16_t moves_free(const uint16_t* walls, uint8_t type,
+                           uint8_t r, int8_t y) {
+  uint16_t blocked = 0;
+  uint16_t wall_row;
+  uint8_t brick_row;
+  uint8_t brick_ix;
+  uint8_t brick_iy;
+  for (brick_iy = BRICK_TOP[r][type];
+       brick_iy <= BRICK_BOTTOM[r][type]; ++brick_iy) {
+    wall_row = walls[y + brick_iy + TMOVES_Y_OFS];
+    brick_row = BRICK_ROWS[r][type][brick_iy];
+    for (brick_ix = 0; brick_row; ++brick_ix, brick_row >>= 1) {
+      if (brick_row & 1) { blocked |= wall_row >> brick_ix; }
+    }
+  }
+  return ~blocked & TMOVES_X_MASK;
+}
+
+/*
+ * Find every lock position for the game's current brick.
+ * Starting from the brick's row, each row is 'flooded' with
+ * sideways moves and rotations; whatever can then move down
+ * starts the next row, and whatever can't is locked there.
+ * Returns how many distinct lock positions were listed.
+ */
+uint8_t tetris_gen_moves(tetris_moves_t* mv, const tetris_game_t* g) {
+  uint16_t walls[TMOVES_ROWS + 4];
+  uint16_t free_cur[4];
+  uint16_t free_next[4];
+  uint16_t reach[4];
+  uint16_t grown;
+  uint16_t any;
+  uint16_t lock_row;
+  uint16_t same;
+  uint8_t type = g->cur.type;
+  uint8_t changed;
+  uint8_t same_r;
+  uint8_t r;
+  uint8_t rot_i;
+  uint8_t rot_r;
+  uint8_t bit_i;
+  int8_t same_dx;
+  int8_t same_iy;
+  int8_t grid_iy;
+  int8_t y;
+  mv->count = 0;
+  mv->overflow = 0;
+  for (r = 0; r < 4; ++r) {
+    for (grid_iy = 0; grid_iy < TMOVES_ROWS; ++grid_iy) {
+      mv->locks[r][grid_iy] = 0;
+    }
+  }
+  // (Rows above the grid are empty, and rows below it are
+  //  solid, so that bricks stop at the floor.)
+  for (grid_iy = -TMOVES_Y_OFS; grid_iy < TMOVES_ROWS; ++grid_iy) {
+    if (grid_iy < 0) {
+      walls[grid_iy + TMOVES_Y_OFS] = TMOVES_WALLS;
+    }
+    else if (grid_iy > 19) {
+      walls[grid_iy + TMOVES_Y_OFS] = 0xFFFF;
+    }
+    else {
+      walls[grid_iy + TMOVES_Y_OFS] =
+        (g->rows[grid_iy] << TMOVES_X_OFS) | TMOVES_WALLS;
+    }
+  }
+  y = g->cur.y;
+  for (r = 0; r < 4; ++r) {
+    free_cur[r] = moves_free(walls, type, r, y);
+    reach[r] = 0;
+  }
+  reach[g->cur.r] = (1 << (g->cur.x + TMOVES_X_OFS)) & free_cur[g->cur.r];
+  if (!reach[g->cur.r]) { return 0; }
+
+  for (; y <= 19; ++y) {
+    // Slide and rotate until nothing new is reached.
+    do {
+      changed = 0;
+      for (r = 0; r < 4; ++r) {
+        grown = reach[r];
+        do {
+          reach[r] = grown;
+          grown = (grown | (grown << 1) | (grown >> 1)) & free_cur[r];
+        } while (grown != reach[r]);
+        for (rot_i = 1; rot_i < 4; rot_i += 2) {
+          rot_r = (r + rot_i) & 3;
+          grown = reach[rot_r] | (reach[r] & free_cur[rot_r]);
+          if (grown != reach[rot_r]) {
+            reach[rot_r] = grown;
+            changed = 1;
+          }
+        }
+      }
+    } while (changed);
+    // Move down a row, or lock.
+    any = 0;
+    for (r = 0; r < 4; ++r) {
+      free_next[r] = moves_free(walls, type, r, y + 1);
+      mv->locks[r][y + TMOVES_Y_OFS] = reach[r] & ~free_next[r];
+      reach[r] &= free_next[r];
+      free_cur[r] = free_next[r];
+      any |= reach[r];
+    }
+    if (!any) { break; }
+  }
+
+  // List the lock positions, skipping any which fill the same
+  // cells as one in an earlier rotation. (See 'BRICK_SAME_ROT')
+  for (r = 0; r < 4; ++r) {
+    same_r = BRICK_SAME_ROT[r][type];
+    same_dx = BRICK_LEFT[r][type] - BRICK_LEFT[same_r][type];
+    for (grid_iy = 0; grid_iy < TMOVES_ROWS; ++grid_iy) {
+      lock_row = mv->locks[r][grid_iy];
+      if (!lock_row) { continue; }
+      if (same_r != r) {
+        same_iy = grid_iy + BRICK_TOP[r][type] - BRICK_TOP[same_r][type];
+        if ((same_iy >= 0) && (same_iy < TMOVES_ROWS)) {
+          same = mv->locks[same_r][same_iy];
+          lock_row &= ~((same_dx >= 0) ? (same >> same_dx) :
+                                         (same << -same_dx));
+        }
+      }
+      for (bit_i = 0; lock_row; ++bit_i, lock_row >>= 1) {
+        if (!(lock_row & 1)) { continue; }
+        if (mv->count >= VVC_MOVES_MAX) {
+          mv->overflow = 1;
+          return mv->count;
+        }
+        // (Already offset; this is 'TMOVE' without the adds.)
+        mv->list[mv->count++] = bit_i | (grid_iy << 4) | (r << 9);
+      }
+    }
+  }
+  return mv->count;
+}
@@ -0,0 +1,55 @@
+#ifndef _VVC_TETRIS_MOVES_H
+#define _VVC_TETRIS_MOVES_H
+
+#include "tetris.h"
+
+// Move generator: every place that the current brick can be
+// locked in, starting from where it is now, using the same
+// moves as the buttons (left, right, down, and rotating
+// either way in place) and the same collision checks. That
+// includes sliding in under overhangs ('tucks') and turning
+// once it's under them ('spins').
+// Positions which fill the same cells are only listed once,
+// e.g. the 'I' brick standing in rotation 0 or 2.
+//
+// It's a breadth-first search over (x, y, rotation), done a
+// whole grid row at a time with bitmasks: bit (x + 3) of a
+// mask stands for column 'x', for each rotation and row.
+// Bricks never move up, so one pass from the top down
+// finishes the search; within each row, sideways moves and
+// rotations are repeated until nothing new is reached.
+
+// Grid rows that a brick's position can be on, from -4 to 19.
+#define TMOVES_Y_OFS  (4)
+#define TMOVES_ROWS   (24)
+// Offset from a brick's 'x' to its bit in the masks.
+#define TMOVES_X_OFS  (3)
+// Most lock positions kept; any more are dropped. (Up to 255)
+// Real games rarely have more than 40, but a grid full of
+// holes and overhangs can have over 80.
+#ifndef VVC_MOVES_MAX
+  #define VVC_MOVES_MAX (64)
+#endif
+// A lock position, packed into 16 bits.
+#define TMOVE(x, y, r)  (((x) + TMOVES_X_OFS) |          \
+                         (((y) + TMOVES_Y_OFS) << 4) |  \
+                         ((r) << 9))
+#define TMOVE_X(m)      ((int8_t)((m) & 0x0F) - TMOVES_X_OFS)
+#define TMOVE_Y(m)      ((int8_t)(((m) >> 4) & 0x1F) - TMOVES_Y_OFS)
+#define TMOVE_R(m)      ((m) >> 9)
+
+typedef struct {
+  // Lock positions found for each rotation and row.
+  uint16_t locks[4][TMOVES_ROWS];
+  // The list of distinct lock positions. ('TMOVE' values)
+  uint16_t list[VVC_MOVES_MAX];
+  uint8_t count;
+  // Set if there were more than 'VVC_MOVES_MAX'.
+  uint8_t overflow;
+} tetris_moves_t;
+
+// Find every lock position for the game's current brick.
+// Returns how many were listed; 0 if the brick is stuck.
+uint8_t tetris_gen_moves(tetris_moves_t* mv, const tetris_game_t* g);
+
+#endif
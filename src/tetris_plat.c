@@ -0,0 +1,53 @@
+#include "peripherals.h"
+
+// The engine's platform interface, for the STM32 boards.
+// (See 'src/tetris.h')
+/*
+ * Seed new brick sequences from the free-running TIM3 counter.
+ * When a game starts is up to the player, so it's unpredictable.
+ */
+uint32_t tetris_plat_rng_seed(void) {
+  return TIM3->CNT;
+}
+
+/*
+ * Look a level's gravity up on the speed curve. It's used by
+ * 'game_frame' from the next frame slot on.
+ */
+void tetris_plat_set_speed(uint8_t level) {
+  game_timing.gravity = GRAVITY_CURVE[level];
+}
+
+/*
+ * Something happened in 'game_frame'. Moves and game ticks
+ * are recorded in the replay log, like the buttons' are. (The
+ * computer player's games aren't recorded.)
+ */
+void tetris_plat_frame_event(uint8_t ev) {
+  if (ev == TFRAME_EV_DROP) {
+    uled_state = !uled_state;
+  }
+  #ifdef VVC_REPLAY
+    if (game_state == GAME_STATE_IN_GAME) {
+      if (ev == TFRAME_EV_RIGHT) { REPLAY_RECORD(REPLAY_EV_RIGHT); }
+      else if (ev == TFRAME_EV_LEFT) { REPLAY_RECORD(REPLAY_EV_LEFT); }
+      else { REPLAY_RECORD(REPLAY_EV_TICK); }
+    }
+  #endif
+  state_changed = 1;
+}
+
+/*
+ * Show the 'Game Over' screen, which stops the game's timing.
+ * (When the computer loses in attract mode, just go back
+ *  to the main menu instead.)
+ */
+void tetris_plat_game_over(void) {
+  if (game_state == GAME_STATE_ATTRACT) {
+    game_state = GAME_STATE_MAIN_MENU;
+  }
+  else {
+    game_state = GAME_STATE_GAME_OVER;
+  }
+  uled_state = 0;
+}
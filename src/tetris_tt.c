@@ -0,0 +1,104 @@
+#include "tetris_tt.h"
+#include "zobrist.h"
+
+/*
+ * Use an array of entries as a table, and empty it.
+ */
+void tetris_tt_init(tetris_tt_t* tt, tetris_tt_entry_t* entries,
+                    uint32_t size) {
+  uint32_t entry_i;
+  tt->entries = entries;
+  tt->mask = size - 1;
+  for (entry_i = 0; entry_i < size; ++entry_i) {
+    entries[entry_i].gen = 0;
+  }
+  tt->gen = 0;
+  tt->probes = 0;
+  tt->hits = 0;
+  tt->stores = 0;
+}
+
+/*
+ * Start a new search. (0 marks empty entries, so it's skipped.)
+ */
+void tetris_tt_new_search(tetris_tt_t* tt) {
+  ++tt->gen;
+  if (!tt->gen) { tt->gen = 1; }
+}
+
+/*
+ * XOR together the keys of the filled cells in a grid row.
+ */
+static uint32_t tt_hash_cells(uint32_t hash, uint8_t grid_iy,
+                              uint16_t cells) {
+  uint8_t grid_ix;
+  for (grid_ix = 0; cells; ++grid_ix, cells >>= 1) {
+    if (cells & 1) { hash ^= ZOBRIST_CELLS[grid_iy][grid_ix]; }
+  }
+  return hash;
+}
+
+/*
+ * Hash a grid from scratch.
+ */
+uint32_t tetris_tt_hash_rows(const uint16_t* rows) {
+  uint32_t hash = 0;
+  uint8_t grid_iy;
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    hash = tt_hash_cells(hash, grid_iy, rows[grid_iy]);
+  }
+  return hash;
+}
+
+/*
+ * Add a brick's cells to a grid's hash. (The brick must be
+ * inside the grid, as it is once it has been placed.)
+ */
+uint32_t tetris_tt_hash_brick(uint32_t hash, uint8_t type,
+                              int8_t r, int8_t x, int8_t y) {
+  uint8_t brick_iy;
+  for (brick_iy = BRICK_TOP[r][type];
+       brick_iy <= BRICK_BOTTOM[r][type]; ++brick_iy) {
+    hash = tt_hash_cells(hash, y + brick_iy,
+      (uint16_t)(BRICK_ROWS[r][type][brick_iy] << (x + 4)) >> 4);
+  }
+  return hash;
+}
+
+/*
+ * The key for a grid hash with a brick still to place on it.
+ */
+uint32_t tetris_tt_key(uint32_t hash, uint8_t type) {
+  return hash ^ ZOBRIST_TYPES[type];
+}
+
+/*
+ * Look a key up: the low bits pick its entry, and the whole
+ * key has to match the one stored there.
+ */
+uint8_t tetris_tt_probe(tetris_tt_t* tt, uint32_t key, int16_t* score) {
+  tetris_tt_entry_t* entry = &tt->entries[key & tt->mask];
+  ++tt->probes;
+  if (!entry->gen || entry->key != key) { return 0; }
+  ++tt->hits;
+  *score = entry->score;
+  return 1;
+}
+
+/*
+ * Store a key's score. An entry is replaced unless it was
+ * stored by this search with more bricks left to place, so
+ * that the results which save the most work stay in the table
+ * for as long as they can be used; anything from an earlier
+ * search can be replaced.
+ */
+void tetris_tt_store(tetris_tt_t* tt, uint32_t key, int16_t score,
+                     uint8_t depth) {
+  tetris_tt_entry_t* entry = &tt->entries[key & tt->mask];
+  if ((entry->gen == tt->gen) && (entry->depth > depth)) { return; }
+  entry->key = key;
+  entry->score = score;
+  entry->gen = tt->gen;
+  entry->depth = depth;
+  ++tt->stores;
+}
@@ -0,0 +1,70 @@
+#ifndef _VVC_TETRIS_TT_H
+#define _VVC_TETRIS_TT_H
+
+#include "tetris.h"
+
+// Transposition table for the computer player's lookahead
+// search. Different placements can leave the same grid behind
+// (an 'O' brick looks the same in every rotation, and two
+// bricks of one type can be dropped in either order), so the
+// search remembers what it worked out for each grid it has
+// seen, under a Zobrist hash of it: the XOR of a random key
+// for each filled cell (src/zobrist.h, from 'make zobrist')
+// and one for the brick which is still to be placed on it.
+// Placing a brick only XORs in the keys of its cells; a grid
+// is only hashed from scratch after rows are cleared.
+// The table has a fixed number of entries (a power of 2) and
+// one entry per hash; each entry keeps the whole 32-bit hash,
+// so only another grid with the same hash can be mistaken for
+// it. It is sized by the caller: 512 bytes on the board
+// ('make AI_TT=64'), megabytes on a host.
+
+// Brick type to hash with a grid which has nothing left to
+// place on it.
+#define TT_NO_BRICK (7)
+// Stored in place of a score for a grid on which no brick fits.
+#define TT_SCORE_NONE (-0x8000)
+
+typedef struct {
+  // The whole hash, to check that it is the same grid.
+  uint32_t key;
+  int16_t score;
+  // The search which stored it, or 0 for an empty entry.
+  uint8_t gen;
+  // Number of bricks still to be placed when it was stored;
+  // deeper entries took more work to get.
+  uint8_t depth;
+} tetris_tt_entry_t;
+
+typedef struct {
+  tetris_tt_entry_t* entries;
+  uint32_t mask;
+  uint8_t gen;
+  // Lookups, how many of them found an entry, and stores.
+  uint32_t probes;
+  uint32_t hits;
+  uint32_t stores;
+} tetris_tt_t;
+
+// Use an array of 'size' entries as a table, and empty it.
+// ('size' must be a power of 2.)
+void tetris_tt_init(tetris_tt_t* tt, tetris_tt_entry_t* entries,
+                    uint32_t size);
+// Start a new search. Entries from earlier searches are still
+// used, but are the first to be replaced.
+void tetris_tt_new_search(tetris_tt_t* tt);
+// Hash a grid from scratch.
+uint32_t tetris_tt_hash_rows(const uint16_t* rows);
+// Add a brick's cells to a grid's hash.
+uint32_t tetris_tt_hash_brick(uint32_t hash, uint8_t type,
+                              int8_t r, int8_t x, int8_t y);
+// The key for a grid hash with a brick still to place on it.
+uint32_t tetris_tt_key(uint32_t hash, uint8_t type);
+// Look a key up. Returns 1 with 'score' set if it is there.
+uint8_t tetris_tt_probe(tetris_tt_t* tt, uint32_t key, int16_t* score);
+// Store a key's score, unless its entry holds a deeper result
+// from this search.
+void tetris_tt_store(tetris_tt_t* tt, uint32_t key, int16_t score,
+                     uint8_t depth);
+
+#endif
@@ -57,138 +57,380 @@ void ssd1331_start_sequence(void) {
   // ideal command ordering, but let's see what happens.
   // 'Unlock Display.' - 0xFD/0x16 can 'Lock' it,
   // in which case all other commands are ignored.
-  sspi_cmd(0xFD);
-  sspi_cmd(0x12);
+  oled_cmd(0xFD);
+  oled_cmd(0x12);
   // (Turn the display off.)
-  sspi_cmd(0xAE);
+  oled_cmd(0xAE);
 
   // 'Set Column Address' - default is 0-95, which is
   // also what we want.
-  sspi_cmd(0x15);
-  sspi_cmd(0x00);
-  sspi_cmd(0x5F);
+  oled_cmd(0x15);
+  oled_cmd(0x00);
+  oled_cmd(0x5F);
   // 'Set Row Address' - default is 0-63, which is good.
-  sspi_cmd(0x75);
-  sspi_cmd(0x00);
-  sspi_cmd(0x3F);
+  oled_cmd(0x75);
+  oled_cmd(0x00);
+  oled_cmd(0x3F);
 
   // 'Set Color A Contrast' - default is 128.
-  sspi_cmd(0x81);
-  sspi_cmd(0x80);
+  oled_cmd(0x81);
+  oled_cmd(0x80);
   // 'Set Color B Contrast' - default is 128, use 96.
-  sspi_cmd(0x82);
-  sspi_cmd(0x60);
+  oled_cmd(0x82);
+  oled_cmd(0x60);
   // 'Set Color C Contrast' - default is 128.
-  sspi_cmd(0x83);
-  sspi_cmd(0x80);
+  oled_cmd(0x83);
+  oled_cmd(0x80);
   // 'Set Master Current Control' - default is 15, but
   // use 8 for ~half. (~= 'Set Brightness')
-  sspi_cmd(0x87);
-  sspi_cmd(0x08);
+  oled_cmd(0x87);
+  oled_cmd(0x08);
   // 'Set Precharge A' - default is 'Color A Contrast'.
-  sspi_cmd(0x8A);
-  sspi_cmd(0x80);
+  oled_cmd(0x8A);
+  oled_cmd(0x80);
   // 'Set Precharge B' - default is 'Color B Contrast'.
-  sspi_cmd(0x8B);
-  sspi_cmd(0x60);
+  oled_cmd(0x8B);
+  oled_cmd(0x60);
   // 'Set Precharge C' - default is 'Color C Contrast'.
-  sspi_cmd(0x8C);
-  sspi_cmd(0x80);
+  oled_cmd(0x8C);
+  oled_cmd(0x80);
   // 'Remap Display Settings' - default is 0x40.
   // Use 0x60 to avoid drawing lines in odd-even order.
-  sspi_cmd(0xA0);
-  //sspi_cmd(0x60);
+  oled_cmd(0xA0);
+  //oled_cmd(0x60);
   // (0x70 to flip vertically)
-  //sspi_cmd(0x70);
+  //oled_cmd(0x70);
   // (And 0x72 to flip horizontally)
-  sspi_cmd(0x72);
+  oled_cmd(0x72);
   // 'Set Display Start Row' - default is 0.
-  sspi_cmd(0xA1);
-  sspi_cmd(0x00);
+  oled_cmd(0xA1);
+  oled_cmd(0x00);
   // 'Set Vertical Offset' - default is 0.
-  sspi_cmd(0xA2);
-  sspi_cmd(0x00);
+  oled_cmd(0xA2);
+  oled_cmd(0x00);
   // 'Set Display Mode' - default is 'A4'. 'A7' = invert.
   // (The actual command byte sets the mode; no 'arg')
-  sspi_cmd(0xA4);
+  oled_cmd(0xA4);
   // 'Set Multiplex Ratio.' I think this is how many
   // rows of pixels are actually enabled; default is 63.
-  sspi_cmd(0xA8);
-  sspi_cmd(0x3F);
+  oled_cmd(0xA8);
+  oled_cmd(0x3F);
   // (I am going to ignore the 0xAB 'Dim Mode Settings'
   // command - it looks like it only matters if we use
   // the 0xAC 'Dim Display' command; we will use 0xAF.)
   // 'Set Voltage Supply Configuration'. The SSD1331 has
   // no onboard charge pump, so we must use external
   // voltage. (0x8E)
-  sspi_cmd(0xAB);
-  sspi_cmd(0x8E);
+  oled_cmd(0xAB);
+  oled_cmd(0x8E);
   // 'Set Power Save Mode'. Default enabled; disable it.
   // ('on' is 0x1A, 'off' is 0x0B)
-  sspi_cmd(0xB0);
-  sspi_cmd(0x0B);
+  oled_cmd(0xB0);
+  oled_cmd(0x0B);
   // 'Adjust Precharge Phases.' Bits [7:4] set the
   // precharge stage 2 period, bits [3:0] set phase 1.
   // Default is 0x74.
-  sspi_cmd(0xB1);
-  sspi_cmd(0x74);
+  oled_cmd(0xB1);
+  oled_cmd(0x74);
   // 'Set Clock Divider Frequency'. Bits [7:4] set the
   // oscillator frequency, bits [3:0]+1 set the
   // clock division ratio. Default is 0xD0.
-  sspi_cmd(0xB3);
-  sspi_cmd(0xD0);
+  oled_cmd(0xB3);
+  oled_cmd(0xD0);
   // (I am going to ignore the 'Set Grayscale Table'
   // command - it has a bunch of gamma curve settings.)
   // So, the 'Reset to Default Grayscale Table'
   // command does make sense to call.
-  sspi_cmd(0xB9);
+  oled_cmd(0xB9);
   // 'Set Precharge Level'. Default is 0x3E.
-  sspi_cmd(0xBB);
-  sspi_cmd(0x3E);
+  oled_cmd(0xBB);
+  oled_cmd(0x3E);
   // 'Set Logic 0 Threshold'. Default is 0x3E = 0.83*VCC.
-  sspi_cmd(0xBE);
-  sspi_cmd(0x3E);
+  oled_cmd(0xBE);
+  oled_cmd(0x3E);
   // 'Display On'.
-  sspi_cmd(0xAF);
+  oled_cmd(0xAF);
+}
+
+#ifndef VVC_OLED_SCANLINE
+/*
+ * Record that a region of the framebuffer has changed, so
+ * that the next 'sspi_stream_framebuffer' call sends it.
+ * Coordinates are inclusive. Touching rectangles are merged;
+ * if the list is full, the new region is folded into
+ * whichever rectangle grows the least.
+ */
+void oled_mark_dirty(int x0, int y0, int x1, int y1) {
+  uint8_t rect_i;
+  uint8_t best_i = 0;
+  int best_area = 0x7FFFFFFF;
+  int ux0, uy0, ux1, uy1, u_area;
+  // Clip to the display.
+  if (x0 < 0) { x0 = 0; }
+  if (y0 < 0) { y0 = 0; }
+  if (x1 > 95) { x1 = 95; }
+  if (y1 > 63) { y1 = 63; }
+  if (x0 > x1 || y0 > y1) { return; }
+  for (rect_i = 0; rect_i < oled_num_dirty; ++rect_i) {
+    ux0 = (x0 < oled_dirty[rect_i].x0) ? x0 : oled_dirty[rect_i].x0;
+    uy0 = (y0 < oled_dirty[rect_i].y0) ? y0 : oled_dirty[rect_i].y0;
+    ux1 = (x1 > oled_dirty[rect_i].x1) ? x1 : oled_dirty[rect_i].x1;
+    uy1 = (y1 > oled_dirty[rect_i].y1) ? y1 : oled_dirty[rect_i].y1;
+    if ((x0 <= oled_dirty[rect_i].x1 + 1) &&
+        (x1 + 1 >= oled_dirty[rect_i].x0) &&
+        (y0 <= oled_dirty[rect_i].y1 + 1) &&
+        (y1 + 1 >= oled_dirty[rect_i].y0)) {
+      // The rectangles touch; merge them.
+      best_i = rect_i;
+      best_area = 0;
+      break;
+    }
+    u_area = (ux1 - ux0 + 1) * (uy1 - uy0 + 1);
+    if (u_area < best_area) {
+      best_area = u_area;
+      best_i = rect_i;
+    }
+  }
+  if (best_area != 0 && oled_num_dirty < OLED_DIRTY_MAX) {
+    // Start a new rectangle.
+    oled_dirty[oled_num_dirty].x0 = x0;
+    oled_dirty[oled_num_dirty].y0 = y0;
+    oled_dirty[oled_num_dirty].x1 = x1;
+    oled_dirty[oled_num_dirty].y1 = y1;
+    ++oled_num_dirty;
+    return;
+  }
+  // Grow an existing rectangle.
+  if (x0 < oled_dirty[best_i].x0) { oled_dirty[best_i].x0 = x0; }
+  if (y0 < oled_dirty[best_i].y0) { oled_dirty[best_i].y0 = y0; }
+  if (x1 > oled_dirty[best_i].x1) { oled_dirty[best_i].x1 = x1; }
+  if (y1 > oled_dirty[best_i].y1) { oled_dirty[best_i].y1 = y1; }
+}
+#endif
+
+#ifdef OLED_HW_ACCEL
+// Current state of the SSD1331's rectangle 'fill' setting.
+static uint8_t ssd1331_fill_on = 0xFF;
+// While drawing a rectangle, the area which changed in the
+// framebuffer is collected here instead of being marked dirty.
+static uint8_t oled_capture_on = 0;
+static uint8_t oled_capture_x0, oled_capture_y0;
+static uint8_t oled_capture_x1, oled_capture_y1;
+
+/*
+ * Send an RGB565 color as the SSD1331's three 6-bit
+ * drawing color components.
+ */
+static void ssd1331_send_color(uint16_t color) {
+  oled_cmd((color >> 11) << 1);
+  oled_cmd((color >> 5) & 0x3F);
+  oled_cmd((color << 1) & 0x3F);
+}
+
+/*
+ * Turn the rectangle command's fill on or off, if needed.
+ */
+static void ssd1331_set_fill(uint8_t fill) {
+  if (ssd1331_fill_on == fill) { return; }
+  oled_cmd(SSD1331_CMD_FILL_MODE);
+  oled_cmd(fill);
+  ssd1331_fill_on = fill;
+}
+
+/*
+ * Draw a line directly in the display's RAM.
+ */
+void ssd1331_draw_line(uint8_t x0, uint8_t y0,
+                       uint8_t x1, uint8_t y1,
+                       uint16_t color) {
+  oled_cmd(SSD1331_CMD_DRAW_LINE);
+  oled_cmd(x0);
+  oled_cmd(y0);
+  oled_cmd(x1);
+  oled_cmd(y1);
+  ssd1331_send_color(color);
+  delay_us(SSD1331_ACCEL_WAIT_US((x1 - x0) + (y1 - y0) + 1));
+}
+
+/*
+ * Draw a rectangle directly in the display's RAM; either
+ * filled with 'color', or as a 1-pixel outline.
+ */
+void ssd1331_draw_rect(uint8_t x0, uint8_t y0,
+                       uint8_t x1, uint8_t y1,
+                       uint16_t color, uint8_t fill) {
+  ssd1331_set_fill(fill);
+  oled_cmd(SSD1331_CMD_DRAW_RECT);
+  oled_cmd(x0);
+  oled_cmd(y0);
+  oled_cmd(x1);
+  oled_cmd(y1);
+  // (Outline color, then fill color.)
+  ssd1331_send_color(color);
+  ssd1331_send_color(color);
+  delay_us(SSD1331_ACCEL_WAIT_US((x1 - x0 + 1) * (y1 - y0 + 1)));
+}
+
+/*
+ * Clear a window of the display's RAM to black.
+ */
+void ssd1331_clear_window(uint8_t x0, uint8_t y0,
+                          uint8_t x1, uint8_t y1) {
+  oled_cmd(SSD1331_CMD_CLEAR_WINDOW);
+  oled_cmd(x0);
+  oled_cmd(y0);
+  oled_cmd(x1);
+  oled_cmd(y1);
+  delay_us(SSD1331_ACCEL_WAIT_US((x1 - x0 + 1) * (y1 - y0 + 1)));
+}
+
+/*
+ * Copy a window of the display's RAM to a new position.
+ */
+void ssd1331_copy(uint8_t x0, uint8_t y0,
+                  uint8_t x1, uint8_t y1,
+                  uint8_t nx, uint8_t ny) {
+  oled_cmd(SSD1331_CMD_COPY);
+  oled_cmd(x0);
+  oled_cmd(y0);
+  oled_cmd(x1);
+  oled_cmd(y1);
+  oled_cmd(nx);
+  oled_cmd(ny);
+  delay_us(SSD1331_ACCEL_WAIT_US((x1 - x0 + 1) * (y1 - y0 + 1)));
+}
+
+/*
+ * Move a region of pixels down by 'dy' rows, both in the
+ * framebuffer and (with copy commands) on the display.
+ * 'x0' must be even and 'x1' odd, to copy whole bytes. The
+ * source rows are left as they were, like the SSD1331 does.
+ * It isn't known which order the SSD1331 copies rows in, so
+ * the display is sent bands of at most 'dy' rows, from the
+ * bottom up; no band's source overlaps its destination, or
+ * any rows which a later band still has to copy.
+ */
+void oled_shift_down(uint8_t x0, uint8_t y0,
+                     uint8_t x1, uint8_t y1, uint8_t dy) {
+  int y_pos;
+  int band_y0;
+  uint8_t fb_x;
+  if (!dy) { return; }
+  if (y1 + dy > 63) { y1 = 63 - dy; }
+  if (y0 > y1) { return; }
+  // (Work from the bottom up, since the regions overlap.)
+  for (y_pos = y1; y_pos >= y0; --y_pos) {
+    for (fb_x = x0 / 2; fb_x <= x1 / 2; ++fb_x) {
+      oled_fb[fb_x + ((y_pos + dy) * OLED_FB_ROW)] =
+        oled_fb[fb_x + (y_pos * OLED_FB_ROW)];
+    }
+  }
+  for (y_pos = y1; y_pos >= y0; y_pos = band_y0 - 1) {
+    band_y0 = y_pos - dy + 1;
+    if (band_y0 < y0) { band_y0 = y0; }
+    ssd1331_copy(x0, band_y0, x1, y_pos, x0, band_y0 + dy);
+  }
+}
+#endif
+
+/*
+ * Report a solid-colored region of the framebuffer which has
+ * just changed. Large enough regions are drawn on the display
+ * with an accelerated command, since the framebuffer already
+ * matches; smaller ones are marked as dirty to be streamed.
+ */
+static void oled_region_changed(int x0, int y0, int x1, int y1,
+                                uint8_t color) {
+#ifdef OLED_HW_ACCEL
+  int px_area = (x1 - x0 + 1) * (y1 - y0 + 1);
+  if (oled_capture_on) {
+    if (x0 < oled_capture_x0) { oled_capture_x0 = x0; }
+    if (y0 < oled_capture_y0) { oled_capture_y0 = y0; }
+    if (x1 > oled_capture_x1) { oled_capture_x1 = x1; }
+    if (y1 > oled_capture_y1) { oled_capture_y1 = y1; }
+    return;
+  }
+  if (px_area >= OLED_ACCEL_MIN_PX) {
+    if (oled_colors[color & 0x0F] == 0x0000) {
+      ssd1331_clear_window(x0, y0, x1, y1);
+    }
+    else if (x0 == x1 || y0 == y1) {
+      ssd1331_draw_line(x0, y0, x1, y1, oled_colors[color & 0x0F]);
+    }
+    else {
+      ssd1331_draw_rect(x0, y0, x1, y1, oled_colors[color & 0x0F], 1);
+    }
+    return;
+  }
+#else
+  // (Only the drawing commands need the color.)
+  (void)color;
+#endif
+  oled_mark_dirty(x0, y0, x1, y1);
+}
+
+/*
+ * Fill a rectangle of the framebuffer, one span per row, and
+ * report the area which changed. Coordinates are inclusive,
+ * and are clipped to the display and the current band.
+ */
+static void oled_fill_rect(int x0, int y0, int x1, int y1,
+                           uint8_t color) {
+  oled_rect_t changed;
+  if (x0 < 0) { x0 = 0; }
+  if (x1 > 95) { x1 = 95; }
+  if (y0 < oled_band_y) { y0 = oled_band_y; }
+  if (y1 >= oled_band_y + OLED_BAND_ROWS) {
+    y1 = oled_band_y + OLED_BAND_ROWS - 1;
+  }
+  if ((x0 > x1) || (y0 > y1)) { return; }
+  if (oled_fill_rows(oled_fb, oled_band_y, x0, y0, x1, y1, color,
+                     &changed)) {
+    oled_region_changed(changed.x0, changed.y0,
+                        changed.x1, changed.y1, color);
+  }
 }
 
 /*
  * Draw a horizontal line.
+ * Only pixels which actually change are marked as dirty.
  */
 inline void oled_draw_h_line(int x, int y,
                              int w, uint8_t color) {
-  int x_pos = x;
-  int line_end = x + w;
-  int fb_ind;
-  // Make sure that the line won't overflow.
-  if (x > 95) { return; }
-  if (line_end > 96) { line_end = 96; }
-  // Draw the line.
-  for (x_pos = x; x_pos < line_end; ++x_pos) {
-    // (2 pixels per byte)
-    fb_ind = (x_pos + (y * 96)) / 2;
-    oled_fb[fb_ind] &= ~((0x0F) << (4 * !(x_pos % 2)));
-    oled_fb[fb_ind] |= (color & 0x0F) << (4 * !(x_pos % 2));
-  }
+  oled_fill_rect(x, y, x + w - 1, y, color);
 }
 
 /*
  * Draw a veritcal line.
+ * Only pixels which actually change are marked as dirty.
  */
 inline void oled_draw_v_line(int x, int y,
                              int h, uint8_t color) {
   int y_pos = y;
   int line_end = y + h;
   int fb_ind;
-  // Make sure that the line won't overflow.
-  if (y > 63) { return; }
-  if (line_end > 64) { line_end = 64; }
-  // Draw the line.
-  for (y_pos = y; y_pos < line_end; ++y_pos) {
-    // (2 pixels per byte)
-    fb_ind = (x + (y_pos * 96)) / 2;
-    oled_fb[fb_ind] &= ~((0x0F) << (4 * !(x % 2)));
-    oled_fb[fb_ind] |= (color & 0x0F) << (4 * !(x % 2));
+  int dirty_y0 = -1;
+  int dirty_y1 = -1;
+  uint8_t px_shift = (x & 1) ? 0 : 4;
+  // Clip the line to the display and the current band.
+  if (x < 0 || x > 95) { return; }
+  if (y_pos < oled_band_y) { y_pos = oled_band_y; }
+  if (line_end > oled_band_y + OLED_BAND_ROWS) {
+    line_end = oled_band_y + OLED_BAND_ROWS;
+  }
+  // Draw the line, stepping one framebuffer row at a time.
+  // (2 pixels per byte)
+  fb_ind = (x >> 1) + ((y_pos - oled_band_y) * OLED_FB_ROW);
+  for (; y_pos < line_end; ++y_pos, fb_ind += OLED_FB_ROW) {
+    if (((oled_fb[fb_ind] >> px_shift) & 0x0F) != (color & 0x0F)) {
+      oled_fb[fb_ind] &= ~((0x0F) << px_shift);
+      oled_fb[fb_ind] |= (color & 0x0F) << px_shift;
+      if (dirty_y0 < 0) { dirty_y0 = y_pos; }
+      dirty_y1 = y_pos;
+    }
+  }
+  if (dirty_y0 >= 0) {
+    oled_region_changed(x, dirty_y0, x, dirty_y1, color);
   }
 }
 
@@ -200,46 +442,58 @@ inline void oled_draw_v_line(int x, int y,
  *   - outline: If <=0, fill the rectangle with 'color'.
  *        If >0, draw an outline inside the dimensions of N pixels.
  *   - color: If 0, clear drawn bits. If not 0, set drawn bits.
+ * With display acceleration, the changed area is collected
+ * while drawing and sent as one command afterwards.
  */
 inline void oled_draw_rect(int x, int y, int w, int h,
                            int outline, uint8_t color) {
+#ifdef OLED_HW_ACCEL
+  oled_capture_on = 1;
+  oled_capture_x0 = 0xFF;
+  oled_capture_y0 = 0xFF;
+  oled_capture_x1 = 0;
+  oled_capture_y1 = 0;
+#endif
   if (outline > 0) {
-    // Draw an outline.
-    int o_pos;
-    // Top.
-    for (o_pos = y; o_pos < (y+outline); ++o_pos) {
-      oled_draw_h_line(x, o_pos, w, color);
-    }
-    // Bottom.
-    for (o_pos = (y+h-1); o_pos > (y+h-1-outline); --o_pos) {
-      oled_draw_h_line(x, o_pos, w, color);
-    }
-    // Left.
-    for (o_pos = x; o_pos < (x+outline); ++o_pos) {
-      oled_draw_v_line(o_pos, y, h, color);
-    }
-    // Right.
-    for (o_pos = (x+w-1); o_pos > (x+w-1-outline); --o_pos) {
-      oled_draw_v_line(o_pos, y, h, color);
-    }
+    // Draw an outline as four filled strips: the top and
+    // bottom edges, then the sides between them.
+    int side_w = (outline < w) ? outline : w;
+    int side_h = (outline < h) ? outline : h;
+    oled_fill_rect(x, y, x + w - 1, y + side_h - 1, color);
+    oled_fill_rect(x, y + h - side_h, x + w - 1, y + h - 1, color);
+    oled_fill_rect(x, y, x + side_w - 1, y + h - 1, color);
+    oled_fill_rect(x + w - side_w, y, x + w - 1, y + h - 1, color);
   }
   else {
     // Draw a filled rectangle.
-    if (w > h) {
-      // Draw fewer horizontal lines than vertical ones.
-      int y_pos;
-      for (y_pos = y; y_pos < (y+h); ++y_pos) {
-        oled_draw_h_line(x, y_pos, w, color);
-      }
-    }
-    else {
-      // Draw fewer (or ==) vertical lines than horizontal ones.
-      int x_pos;
-      for (x_pos = x; x_pos < (x+w); ++x_pos) {
-        oled_draw_v_line(x_pos, y, h, color);
-      }
+    oled_fill_rect(x, y, x + w - 1, y + h - 1, color);
+  }
+#ifdef OLED_HW_ACCEL
+  oled_capture_on = 0;
+  if (oled_capture_x0 > oled_capture_x1) {
+    // Nothing changed.
+    return;
+  }
+  if (outline <= 0) {
+    oled_region_changed(oled_capture_x0, oled_capture_y0,
+                        oled_capture_x1, oled_capture_y1, color);
+  }
+  else if ((x >= 0) && (y >= 0) && (x + w <= 96) && (y + h <= 64) &&
+           ((outline * 2) < w) && ((outline * 2) < h)) {
+    // Draw the outline as nested 1-pixel rectangles.
+    int o_pos;
+    for (o_pos = 0; o_pos < outline; ++o_pos) {
+      ssd1331_draw_rect(x + o_pos, y + o_pos,
+                        x + w - 1 - o_pos, y + h - 1 - o_pos,
+                        oled_colors[color & 0x0F], 0);
     }
   }
+  else {
+    // (Clipped or degenerate outlines are just streamed.)
+    oled_mark_dirty(oled_capture_x0, oled_capture_y0,
+                    oled_capture_x1, oled_capture_y1);
+  }
+#endif
 }
 
 /*
@@ -253,416 +507,213 @@ inline void oled_draw_rect(int x, int y, int w, int h,
  * 'color' indicates whether to set or unset the pixel. 0 means 'unset.'
  */
 inline void oled_write_pixel(int x, int y, uint8_t color) {
-  int fb_ind = (x + (y * 96)) / 2;
-  oled_fb[fb_ind] &= ~((0x0F) << (4 * !(x % 2)));
-  oled_fb[fb_ind] |= (color & 0x0F) << (4 * !(x % 2));
+  if (!oled_band_hit(y, 1)) { return; }
+  int fb_ind = (x + ((y - oled_band_y) * 96)) / 2;
+  uint8_t px_shift = 4 * !(x % 2);
+  if (((oled_fb[fb_ind] >> px_shift) & 0x0F) != (color & 0x0F)) {
+    oled_fb[fb_ind] &= ~((0x0F) << px_shift);
+    oled_fb[fb_ind] |= (color & 0x0F) << px_shift;
+    oled_mark_dirty(x, y, x, y);
+  }
 }
 
-void oled_draw_letter(int x, int y, unsigned int w0, unsigned int w1, uint8_t color, char size) {
-  // TODO: Make this more efficient than drawing
-  // pixels one-by-one.
-  int w_iter = 0;
-  int cur_x = x;
-  int cur_y = y;
-  unsigned int aw0 = w0;
-  unsigned int aw1 = w1;
-  if (!color) {
-    aw0 = ~aw0;
-    aw1 = ~aw1;
-  }
-  int px_incr = 1;
-  int line_h = 8;
-  unsigned char t_col = 0x00;
-  int cx = cur_x;
-  int cy = cur_y;
-  if (size == 'L') {
-    px_incr = 2;
-    line_h = 16;
-  }
-  for (w_iter = 31; w_iter >= 0; --w_iter) {
-    t_col = !(!(aw0 & (1 << w_iter)));
-    for (cx = cur_x; cx < cur_x + px_incr; ++cx) {
-      for (cy = cur_y; cy < cur_y + px_incr; ++cy) {
-        if (t_col) {
-          oled_write_pixel(cx, cy, color);
-        }
-      }
-    }
-    cur_y += px_incr;
-    if (cur_y == y+line_h) {
-      cur_y = y;
-      cur_x += px_incr;
+/*
+ * Font table, indexed by (character code - OLED_FONT_FIRST).
+ * Each glyph is 6 columns of 8 pixels, left to right; the
+ * most significant bit of each column is its top pixel.
+ * The entries are unpacked from the 'OLED_CH_*' words, which
+ * hold the first 4 columns of a character and the last 2
+ * columns of a pair of characters. Missing characters are
+ * left blank.
+ */
+#define OLED_FONT_FIRST (' ')
+#define OLED_FONT_LAST  ('~')
+#define OLED_GLYPH(w0, w1) {                           \
+  ((w0) >> 24) & 0xFF, ((w0) >> 16) & 0xFF,            \
+  ((w0) >> 8) & 0xFF,  (w0) & 0xFF,                    \
+  ((w1) >> 8) & 0xFF,  (w1) & 0xFF }
+#define OLED_GLYPH_HI(w0, w1) OLED_GLYPH(w0, (w1) >> 16)
+#define OLED_GLYPH_LO(w0, w1) OLED_GLYPH(w0, (w1) & 0xFFFF)
+static const uint8_t oled_font[OLED_FONT_LAST - OLED_FONT_FIRST + 1][6] = {
+  ['A' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_A0, OLED_CH_A1B1),
+  ['B' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_B0, OLED_CH_A1B1),
+  ['C' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_C0, OLED_CH_C1D1),
+  ['D' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_D0, OLED_CH_C1D1),
+  ['E' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_E0, OLED_CH_E1F1),
+  ['F' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_F0, OLED_CH_E1F1),
+  ['G' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_G0, OLED_CH_G1H1),
+  ['H' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_H0, OLED_CH_G1H1),
+  ['I' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_I0, OLED_CH_I1J1),
+  ['J' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_J0, OLED_CH_I1J1),
+  ['K' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_K0, OLED_CH_K1L1),
+  ['L' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_L0, OLED_CH_K1L1),
+  ['M' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_M0, OLED_CH_M1N1),
+  ['N' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_N0, OLED_CH_M1N1),
+  ['O' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_O0, OLED_CH_O1P1),
+  ['P' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_P0, OLED_CH_O1P1),
+  ['Q' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_Q0, OLED_CH_Q1R1),
+  ['R' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_R0, OLED_CH_Q1R1),
+  ['S' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_S0, OLED_CH_S1T1),
+  ['T' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_T0, OLED_CH_S1T1),
+  ['U' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_U0, OLED_CH_U1V1),
+  ['V' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_V0, OLED_CH_U1V1),
+  ['W' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_W0, OLED_CH_W1X1),
+  ['X' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_X0, OLED_CH_W1X1),
+  ['Y' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_Y0, OLED_CH_Y1Z1),
+  ['Z' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_Z0, OLED_CH_Y1Z1),
+  ['a' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_a0, OLED_CH_a1b1),
+  ['b' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_b0, OLED_CH_a1b1),
+  ['c' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_c0, OLED_CH_c1d1),
+  ['d' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_d0, OLED_CH_c1d1),
+  ['e' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_e0, OLED_CH_e1f1),
+  ['f' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_f0, OLED_CH_e1f1),
+  ['g' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_g0, OLED_CH_g1h1),
+  ['h' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_h0, OLED_CH_g1h1),
+  ['i' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_i0, OLED_CH_i1j1),
+  ['j' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_j0, OLED_CH_i1j1),
+  ['k' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_k0, OLED_CH_k1l1),
+  ['l' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_l0, OLED_CH_k1l1),
+  ['m' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_m0, OLED_CH_m1n1),
+  ['n' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_n0, OLED_CH_m1n1),
+  ['o' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_o0, OLED_CH_o1p1),
+  ['p' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_p0, OLED_CH_o1p1),
+  ['q' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_q0, OLED_CH_q1r1),
+  ['r' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_r0, OLED_CH_q1r1),
+  ['s' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_s0, OLED_CH_s1t1),
+  ['t' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_t0, OLED_CH_s1t1),
+  ['u' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_u0, OLED_CH_u1v1),
+  ['v' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_v0, OLED_CH_u1v1),
+  ['w' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_w0, OLED_CH_w1x1),
+  ['x' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_x0, OLED_CH_w1x1),
+  ['y' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_y0, OLED_CH_y1z1),
+  ['z' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_z0, OLED_CH_y1z1),
+  ['0' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_00, OLED_CH_0111),
+  ['1' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_10, OLED_CH_0111),
+  ['2' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_20, OLED_CH_2131),
+  ['3' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_30, OLED_CH_2131),
+  ['4' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_40, OLED_CH_4151),
+  ['5' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_50, OLED_CH_4151),
+  ['6' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_60, OLED_CH_6171),
+  ['7' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_70, OLED_CH_6171),
+  ['8' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_80, OLED_CH_8191),
+  ['9' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_90, OLED_CH_8191),
+  [':' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_col0, OLED_CH_col1per1),
+  ['.' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_per0, OLED_CH_col1per1),
+  ['!' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_exc0, OLED_CH_exc1fws1),
+  ['/' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_fws0, OLED_CH_exc1fws1),
+  ['-' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_hyp0, OLED_CH_hyp1pls1),
+  ['+' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_pls0, OLED_CH_hyp1pls1),
+  ['<' - OLED_FONT_FIRST] = OLED_GLYPH_HI(OLED_CH_lct0, OLED_CH_lct1rct1),
+  ['>' - OLED_FONT_FIRST] = OLED_GLYPH_LO(OLED_CH_rct0, OLED_CH_lct1rct1),
+};
+
+/*
+ * Draw one 6x8 glyph, or a 12x16 one if 'size' is 'L'.
+ * Rather than plotting pixels one at a time, this walks the
+ * framebuffer bytes which the glyph covers. Each byte holds
+ * two adjacent screen columns, so the glyph columns for both
+ * nibbles are looked up (the same one twice when scaled up)
+ * and every row in the band is written as a pair of nibbles.
+ * The area which changed is marked dirty once at the end.
+ * If 'color' is 0, the glyph's background is drawn instead.
+ */
+static void oled_draw_glyph(int x, int y, const uint8_t* cols,
+                            uint8_t color, char size) {
+  uint8_t scale = (size == 'L') ? 1 : 0;
+  int g_w = 6 << scale;
+  int g_h = 8 << scale;
+  int b_x, b_end;
+  int y_pos, y_end, row_y;
+  int col_l, col_r;
+  int px_l, px_r;
+  uint8_t mask_l, mask_r;
+  uint8_t row_bit;
+  uint8_t nib_mask;
+  uint8_t c_nib = color & 0x0F;
+  uint8_t c_byte = c_nib | (c_nib << 4);
+  uint8_t old_byte, new_byte;
+  int fb_ind;
+  int dirty_x0 = 96, dirty_x1 = -1;
+  int dirty_y0 = 64, dirty_y1 = -1;
+  // Clip the glyph to the display and the current band.
+  y_pos = (y < oled_band_y) ? oled_band_y : y;
+  y_end = y + g_h;
+  if (y_end > oled_band_y + OLED_BAND_ROWS) {
+    y_end = oled_band_y + OLED_BAND_ROWS;
+  }
+  if (y_pos >= y_end) { return; }
+  b_x = (x < 0) ? 0 : (x >> 1);
+  b_end = (x + g_w - 1) >> 1;
+  if (b_end > (OLED_FB_ROW - 1)) { b_end = OLED_FB_ROW - 1; }
+  for (; b_x <= b_end; ++b_x) {
+    // Find the glyph columns under each nibble of this byte.
+    col_l = (b_x * 2) - x;
+    col_r = col_l + 1;
+    mask_l = (col_l >= 0 && col_l < g_w) ? cols[col_l >> scale] : 0;
+    mask_r = (col_r >= 0 && col_r < g_w) ? cols[col_r >> scale] : 0;
+    if (!color) {
+      if (col_l >= 0 && col_l < g_w) { mask_l = ~mask_l; }
+      if (col_r >= 0 && col_r < g_w) { mask_r = ~mask_r; }
     }
-  }
-  for (w_iter = 15; w_iter >= 0; --w_iter) {
-    t_col = !(!(aw1 & (1 << w_iter)));
-    for (cx = cur_x; cx < cur_x + px_incr; ++cx) {
-      for (cy = cur_y; cy < cur_y + px_incr; ++cy) {
-        if (t_col) {
-          oled_write_pixel(cx, cy, color);
-        }
+    if (!(mask_l | mask_r)) { continue; }
+    fb_ind = b_x + ((y_pos - oled_band_y) * OLED_FB_ROW);
+    for (row_y = y_pos; row_y < y_end; ++row_y, fb_ind += OLED_FB_ROW) {
+      row_bit = 0x80 >> ((row_y - y) >> scale);
+      nib_mask = ((mask_l & row_bit) ? 0xF0 : 0x00) |
+                 ((mask_r & row_bit) ? 0x0F : 0x00);
+      old_byte = oled_fb[fb_ind];
+      new_byte = (old_byte & ~nib_mask) | (c_byte & nib_mask);
+      if (new_byte != old_byte) {
+        oled_fb[fb_ind] = new_byte;
+        // (Only count the nibbles which actually changed.)
+        px_l = b_x * 2 + !((new_byte ^ old_byte) & 0xF0);
+        px_r = b_x * 2 + !!((new_byte ^ old_byte) & 0x0F);
+        if (px_l < dirty_x0) { dirty_x0 = px_l; }
+        if (px_r > dirty_x1) { dirty_x1 = px_r; }
+        if (row_y < dirty_y0) { dirty_y0 = row_y; }
+        if (row_y > dirty_y1) { dirty_y1 = row_y; }
       }
     }
-    cur_y += px_incr;
-    if (cur_y == y+line_h) {
-      cur_y = y;
-      cur_x += px_incr;
-    }
   }
+  if (dirty_x1 >= 0) {
+    oled_mark_dirty(dirty_x0, dirty_y0, dirty_x1, dirty_y1);
+  }
+}
+
+/*
+ * Draw a character given as raw glyph words; 'w0' holds its
+ * first 4 columns and the low 16 bits of 'w1' the last 2.
+ */
+void oled_draw_letter(int x, int y, unsigned int w0, unsigned int w1, uint8_t color, char size) {
+  const uint8_t cols[6] = OLED_GLYPH(w0, w1);
+  oled_draw_glyph(x, y, cols, color, size);
 }
 
 void oled_draw_letter_c(int x, int y, char c, uint8_t color, char size) {
-  unsigned int w0 = 0x00;
-  unsigned int w1 = 0x00;
-  if (c == 'A') {
-    w0 = OLED_CH_A0;
-    w1 = OLED_CH_A1B1 >> 16;
-  }
-  else if (c == 'B') {
-    w0 = OLED_CH_B0;
-    w1 = OLED_CH_A1B1 & 0x0000FFFF;
-  }
-  else if (c == 'C') {
-    w0 = OLED_CH_C0;
-    w1 = OLED_CH_C1D1 >> 16;
-  }
-  else if (c == 'D') {
-    w0 = OLED_CH_D0;
-    w1 = OLED_CH_C1D1 & 0x0000FFFF;
-  }
-  else if (c == 'E') {
-    w0 = OLED_CH_E0;
-    w1 = OLED_CH_E1F1 >> 16;
-  }
-  else if (c == 'F') {
-    w0 = OLED_CH_F0;
-    w1 = OLED_CH_E1F1 & 0x0000FFFF;
-  }
-  else if (c == 'G') {
-    w0 = OLED_CH_G0;
-    w1 = OLED_CH_G1H1 >> 16;
-  }
-  else if (c == 'H') {
-    w0 = OLED_CH_H0;
-    w1 = OLED_CH_G1H1 & 0x0000FFFF;
-  }
-  else if (c == 'I') {
-    w0 = OLED_CH_I0;
-    w1 = OLED_CH_I1J1 >> 16;
-  }
-  else if (c == 'J') {
-    w0 = OLED_CH_J0;
-    w1 = OLED_CH_I1J1 & 0x0000FFFF;
-  }
-  else if (c == 'K') {
-    w0 = OLED_CH_K0;
-    w1 = OLED_CH_K1L1 >> 16;
-  }
-  else if (c == 'L') {
-    w0 = OLED_CH_L0;
-    w1 = OLED_CH_K1L1 & 0x0000FFFF;
-  }
-  else if (c == 'M') {
-    w0 = OLED_CH_M0;
-    w1 = OLED_CH_M1N1 >> 16;
-  }
-  else if (c == 'N') {
-    w0 = OLED_CH_N0;
-    w1 = OLED_CH_M1N1 & 0x0000FFFF;
-  }
-  else if (c == 'O') {
-    w0 = OLED_CH_O0;
-    w1 = OLED_CH_O1P1 >> 16;
-  }
-  else if (c == 'P') {
-    w0 = OLED_CH_P0;
-    w1 = OLED_CH_O1P1 & 0x0000FFFF;
-  }
-  else if (c == 'Q') {
-    w0 = OLED_CH_Q0;
-    w1 = OLED_CH_Q1R1 >> 16;
-  }
-  else if (c == 'R') {
-    w0 = OLED_CH_R0;
-    w1 = OLED_CH_Q1R1 & 0x0000FFFF;
-  }
-  else if (c == 'S') {
-    w0 = OLED_CH_S0;
-    w1 = OLED_CH_S1T1 >> 16;
-  }
-  else if (c == 'T') {
-    w0 = OLED_CH_T0;
-    w1 = OLED_CH_S1T1 & 0x0000FFFF;
-  }
-  else if (c == 'U') {
-    w0 = OLED_CH_U0;
-    w1 = OLED_CH_U1V1 >> 16;
-  }
-  else if (c == 'V') {
-    w0 = OLED_CH_V0;
-    w1 = OLED_CH_U1V1 & 0x0000FFFF;
-  }
-  else if (c == 'W') {
-    w0 = OLED_CH_W0;
-    w1 = OLED_CH_W1X1 >> 16;
-  }
-  else if (c == 'X') {
-    w0 = OLED_CH_X0;
-    w1 = OLED_CH_W1X1 & 0x0000FFFF;
-  }
-  else if (c == 'Y') {
-    w0 = OLED_CH_Y0;
-    w1 = OLED_CH_Y1Z1 >> 16;
-  }
-  else if (c == 'Z') {
-    w0 = OLED_CH_Z0;
-    w1 = OLED_CH_Y1Z1 & 0x0000FFFF;
-  }
-  else if (c == 'a') {
-    w0 = OLED_CH_a0;
-    w1 = OLED_CH_a1b1 >> 16;
-  }
-  else if (c == 'b') {
-    w0 = OLED_CH_b0;
-    w1 = OLED_CH_a1b1 & 0x0000FFFF;
-  }
-  else if (c == 'c') {
-    w0 = OLED_CH_c0;
-    w1 = OLED_CH_c1d1 >> 16;
-  }
-  else if (c == 'd') {
-    w0 = OLED_CH_d0;
-    w1 = OLED_CH_c1d1 & 0x0000FFFF;
-  }
-  else if (c == 'e') {
-    w0 = OLED_CH_e0;
-    w1 = OLED_CH_e1f1 >> 16;
-  }
-  else if (c == 'f') {
-    w0 = OLED_CH_f0;
-    w1 = OLED_CH_e1f1 & 0x0000FFFF;
-  }
-  else if (c == 'g') {
-    w0 = OLED_CH_g0;
-    w1 = OLED_CH_g1h1 >> 16;
-  }
-  else if (c == 'h') {
-    w0 = OLED_CH_h0;
-    w1 = OLED_CH_g1h1 & 0x0000FFFF;
-  }
-  else if (c == 'i') {
-    w0 = OLED_CH_i0;
-    w1 = OLED_CH_i1j1 >> 16;
-  }
-  else if (c == 'j') {
-    w0 = OLED_CH_j0;
-    w1 = OLED_CH_i1j1 & 0x0000FFFF;
-  }
-  else if (c == 'k') {
-    w0 = OLED_CH_k0;
-    w1 = OLED_CH_k1l1 >> 16;
-  }
-  else if (c == 'l') {
-    w0 = OLED_CH_l0;
-    w1 = OLED_CH_k1l1 & 0x0000FFFF;
-  }
-  else if (c == 'm') {
-    w0 = OLED_CH_m0;
-    w1 = OLED_CH_m1n1 >> 16;
-  }
-  else if (c == 'n') {
-    w0 = OLED_CH_n0;
-    w1 = OLED_CH_m1n1 & 0x0000FFFF;
-  }
-  else if (c == 'o') {
-    w0 = OLED_CH_o0;
-    w1 = OLED_CH_o1p1 >> 16;
-  }
-  else if (c == 'p') {
-    w0 = OLED_CH_p0;
-    w1 = OLED_CH_o1p1 & 0x0000FFFF;
-  }
-  else if (c == 'q') {
-    w0 = OLED_CH_q0;
-    w1 = OLED_CH_q1r1 >> 16;
-  }
-  else if (c == 'r') {
-    w0 = OLED_CH_r0;
-    w1 = OLED_CH_q1r1 & 0x0000FFFF;
-  }
-  else if (c == 's') {
-    w0 = OLED_CH_s0;
-    w1 = OLED_CH_s1t1 >> 16;
-  }
-  else if (c == 't') {
-    w0 = OLED_CH_t0;
-    w1 = OLED_CH_s1t1 & 0x0000FFFF;
-  }
-  else if (c == 'u') {
-    w0 = OLED_CH_u0;
-    w1 = OLED_CH_u1v1 >> 16;
-  }
-  else if (c == 'v') {
-    w0 = OLED_CH_v0;
-    w1 = OLED_CH_u1v1 & 0x0000FFFF;
-  }
-  else if (c == 'w') {
-    w0 = OLED_CH_w0;
-    w1 = OLED_CH_w1x1 >> 16;
-  }
-  else if (c == 'x') {
-    w0 = OLED_CH_x0;
-    w1 = OLED_CH_w1x1 & 0x0000FFFF;
-  }
-  else if (c == 'y') {
-    w0 = OLED_CH_y0;
-    w1 = OLED_CH_y1z1 >> 16;
-  }
-  else if (c == 'z') {
-    w0 = OLED_CH_z0;
-    w1 = OLED_CH_y1z1 & 0x0000FFFF;
-  }
-  else if (c == '0') {
-    w0 = OLED_CH_00;
-    w1 = OLED_CH_0111 >> 16;
-  }
-  else if (c == '1') {
-    w0 = OLED_CH_10;
-    w1 = OLED_CH_0111 & 0x0000FFFF;
-  }
-  else if (c == '2') {
-    w0 = OLED_CH_20;
-    w1 = OLED_CH_2131 >> 16;
-  }
-  else if (c == '3') {
-    w0 = OLED_CH_30;
-    w1 = OLED_CH_2131 & 0x0000FFFF;
-  }
-  else if (c == '4') {
-    w0 = OLED_CH_40;
-    w1 = OLED_CH_4151 >> 16;
-  }
-  else if (c == '5') {
-    w0 = OLED_CH_50;
-    w1 = OLED_CH_4151 & 0x0000FFFF;
-  }
-  else if (c == '6') {
-    w0 = OLED_CH_60;
-    w1 = OLED_CH_6171 >> 16;
-  }
-  else if (c == '7') {
-    w0 = OLED_CH_70;
-    w1 = OLED_CH_6171 & 0x0000FFFF;
-  }
-  else if (c == '8') {
-    w0 = OLED_CH_80;
-    w1 = OLED_CH_8191 >> 16;
-  }
-  else if (c == '9') {
-    w0 = OLED_CH_90;
-    w1 = OLED_CH_8191 & 0x0000FFFF;
-  }
-  else if (c == ':') {
-    w0 = OLED_CH_col0;
-    w1 = OLED_CH_col1per1 >> 16;
-  }
-  else if (c == '.') {
-    w0 = OLED_CH_per0;
-    w1 = OLED_CH_col1per1 & 0x0000FFFF;
-  }
-  else if (c == '!') {
-    w0 = OLED_CH_exc0;
-    w1 = OLED_CH_exc1fws1 >> 16;
-  }
-  else if (c == '/') {
-    w0 = OLED_CH_fws0;
-    w1 = OLED_CH_exc1fws1 & 0x0000FFFF;
-  }
-  else if (c == '-') {
-    w0 = OLED_CH_hyp0;
-    w1 = OLED_CH_hyp1pls1 >> 16;
-  }
-  else if (c == '+') {
-    w0 = OLED_CH_pls0;
-    w1 = OLED_CH_hyp1pls1 & 0x0000FFFF;
-  }
-  else if (c == '<') {
-    w0 = OLED_CH_lct0;
-    w1 = OLED_CH_lct1rct1 >> 16;
-  }
-  else if (c == '>') {
-    w0 = OLED_CH_rct0;
-    w1 = OLED_CH_lct1rct1 & 0x0000FFFF;
-  }
-  oled_draw_letter(x, y, w0, w1, color, size);
+  if (c < OLED_FONT_FIRST || c > OLED_FONT_LAST) { return; }
+  oled_draw_glyph(x, y, oled_font[c - OLED_FONT_FIRST], color, size);
 }
 
-void oled_draw_letter_i(int x, int y, int ic, uint8_t color, char size) {
-  int magnitude = 1000000000;
+/*
+ * Draw a packed BCD number, one digit per 4 bits, without
+ * leading zeros. The digits are read straight out of the
+ * number, so there is nothing to divide.
+ */
+void oled_draw_bcd(int x, int y, uint32_t bcd, uint8_t color, char size) {
   int cur_x = x;
-  int first_found = 0;
-  int proc_val = ic;
-  if (proc_val < 0) {
-    proc_val = proc_val * -1;
-    oled_draw_letter_c(cur_x, y, '-', color, size);
-    if (size == 'S') {
-      cur_x += 6;
-    }
-    else if (size == 'L') {
-      cur_x += 12;
-    }
-  }
-  for (magnitude = 1000000000; magnitude > 0; magnitude = magnitude / 10) {
-    int m_val = proc_val / magnitude;
-    proc_val -= (m_val * magnitude);
-    if (m_val > 0 || first_found || magnitude == 1) {
-      first_found = 1;
-      char mc = ' ';
-      if (m_val == 0) {
-        mc = '0';
-      }
-      else if (m_val == 1) {
-        mc = '1';
-      }
-      else if (m_val == 2) {
-        mc = '2';
-      }
-      else if (m_val == 3) {
-        mc = '3';
-      }
-      else if (m_val == 4) {
-        mc = '4';
-      }
-      else if (m_val == 5) {
-        mc = '5';
-      }
-      else if (m_val == 6) {
-        mc = '6';
-      }
-      else if (m_val == 7) {
-        mc = '7';
-      }
-      else if (m_val == 8) {
-        mc = '8';
-      }
-      else if (m_val == 9) {
-        mc = '9';
-      }
-      oled_draw_letter_c(cur_x, y, mc, color, size);
-      if (size == 'S') {
-        cur_x += 6;
-      }
-      else if (size == 'L') {
-        cur_x += 12;
-      }
-      if (cur_x >= 128) { return; }
-    }
+  int8_t shift = 28;
+  if (!oled_band_hit(y, (size == 'L') ? 16 : 8)) { return; }
+  while ((shift > 0) && !((bcd >> shift) & 0xF)) { shift -= 4; }
+  for (; shift >= 0; shift -= 4) {
+    oled_draw_letter_c(cur_x, y, '0' + ((bcd >> shift) & 0xF), color, size);
+    cur_x += (size == 'L') ? 12 : 6;
   }
 }
 
 void oled_draw_text(int x, int y, char* cc, uint8_t color, char size) {
   int i = 0;
   int offset = 0;
+  if (!oled_band_hit(y, (size == 'L') ? 16 : 8)) { return; }
   while (cc[i] != '\0') {
     oled_draw_letter_c(x + offset, y, cc[i], color, size);
     if (size == 'S') {
@@ -675,24 +726,286 @@ void oled_draw_text(int x, int y, char* cc, uint8_t color, char size) {
   }
 }
 
-void sspi_stream_framebuffer(void) {
+/*
+ * Refresh the stream expansion table entries which use a
+ * given palette index. Colors go out most-significant byte
+ * first, so each one is stored byte-swapped.
+ */
+static void oled_update_lut(uint8_t idx) {
+  uint16_t wire_col = (oled_colors[idx] >> 8) |
+                      ((oled_colors[idx] & 0x00FF) << 8);
+#ifdef OLED_EXPAND_LUT
+  uint8_t nib_i;
+  for (nib_i = 0; nib_i < 16; ++nib_i) {
+    // Left pixel (high nibble) = first two bytes.
+    oled_expand_lut[(idx << 4) | nib_i] &= 0xFFFF0000;
+    oled_expand_lut[(idx << 4) | nib_i] |= wire_col;
+    // Right pixel (low nibble) = last two bytes.
+    oled_expand_lut[(nib_i << 4) | idx] &= 0x0000FFFF;
+    oled_expand_lut[(nib_i << 4) | idx] |= ((uint32_t)wire_col << 16);
+  }
+#else
+  oled_expand_lut[idx] = wire_col;
+#endif
+}
+
+/*
+ * Load the default color palette and build the stream
+ * expansion table from it.
+ */
+void oled_init_palette(void) {
+  uint8_t col_i;
+  for (col_i = 0; col_i < 16; ++col_i) {
+    oled_colors[col_i] = oled_default_colors[col_i];
+    oled_update_lut(col_i);
+  }
+}
+
+/*
+ * Change one palette color. The expansion table is kept in
+ * sync, and the whole screen is marked dirty since any pixel
+ * might use the changed color.
+ */
+void oled_set_color(uint8_t idx, uint16_t color) {
+  idx &= 0x0F;
+  if (oled_colors[idx] == color) { return; }
+  oled_colors[idx] = color;
+  oled_update_lut(idx);
+  oled_mark_dirty(0, 0, 95, 63);
+}
+
+#ifdef VVC_PROFILE
+/*
+ * Measure the cost of expanding a full frame into display
+ * bytes, the way the stream loop used to (nibble extraction,
+ * two palette lookups and four byte splits per framebuffer
+ * byte) and with the expansion table. No bytes are sent, so
+ * this only counts the CPU work done per frame.
+ */
+void oled_profile_expand(void) {
+  static uint8_t prof_buf[4];
+  uint16_t px_i;
+  uint16_t px_val;
+  uint8_t band_i;
+  uint32_t t0;
+  // (With the scanline renderer, expand its band repeatedly.)
+  t0 = PROFILE_NOW();
+  for (band_i = 0; band_i < 64 / OLED_BAND_ROWS; ++band_i) {
+    for (px_i = 0; px_i < OLED_BUF_SIZE; ++px_i) {
+      px_val = oled_colors[oled_fb[px_i] >> 4];
+      prof_buf[0] = px_val >> 8;
+      prof_buf[1] = px_val & 0x00FF;
+      px_val = oled_colors[oled_fb[px_i] & 0x0F];
+      prof_buf[2] = px_val >> 8;
+      prof_buf[3] = px_val & 0x00FF;
+    }
+  }
+  prof_expand_ref_cycles = PROFILE_SINCE(t0);
+  t0 = PROFILE_NOW();
+  for (band_i = 0; band_i < 64 / OLED_BAND_ROWS; ++band_i) {
+    for (px_i = 0; px_i < OLED_BUF_SIZE; ++px_i) {
+      *(volatile uint32_t*)prof_buf = oled_expand(oled_fb[px_i]);
+    }
+  }
+  prof_expand_lut_cycles = PROFILE_SINCE(t0);
+}
+
+/*
+ * Measure the cost of filling the whole framebuffer, the way
+ * 'oled_draw_h_line' used to (a division and a read-modify-
+ * write per pixel) and with the span fill kernel. Each pass
+ * changes every pixel; the framebuffer is cleared afterwards.
+ */
+void oled_profile_fill(void) {
+  int x_pos, y_pos;
+  int fb_ind;
+  int span_x0, span_x1;
+  uint8_t px_shift;
+  uint32_t t0;
+  t0 = PROFILE_NOW();
+  for (y_pos = 0; y_pos < OLED_BAND_ROWS; ++y_pos) {
+    for (x_pos = 0; x_pos < 96; ++x_pos) {
+      fb_ind = (x_pos + (y_pos * 96)) / 2;
+      px_shift = 4 * !(x_pos % 2);
+      if (((oled_fb[fb_ind] >> px_shift) & 0x0F) != 1) {
+        oled_fb[fb_ind] &= ~((0x0F) << px_shift);
+        oled_fb[fb_ind] |= 1 << px_shift;
+      }
+    }
+  }
+  prof_fill_ref_cycles = PROFILE_SINCE(t0);
+  t0 = PROFILE_NOW();
+  for (y_pos = 0; y_pos < OLED_BAND_ROWS; ++y_pos) {
+    oled_fill_span(&oled_fb[y_pos * OLED_FB_ROW], 0, 95, 2,
+                   &span_x0, &span_x1);
+  }
+  prof_fill_span_cycles = PROFILE_SINCE(t0);
+  for (y_pos = 0; y_pos < OLED_BAND_ROWS; ++y_pos) {
+    oled_fill_span(&oled_fb[y_pos * OLED_FB_ROW], 0, 95, 0,
+                   &span_x0, &span_x1);
+  }
+}
+
+/*
+ * Measure one whole 'oled_render_frame' call: drawing the main
+ * menu and sending every pixel of it to the display, until the
+ * last byte has gone out. This times the stream itself, over
+ * whichever bus the build uses. (With SPI1/DMA, it has to run
+ * once the DMA interrupt is enabled.)
+ */
+void oled_profile_frame(void) {
+  uint32_t t0;
+  oled_fb_screen = OLED_SCREEN_NONE;
+  oled_mark_dirty(0, 0, 95, 63);
+  t0 = PROFILE_NOW();
+  oled_render_frame(draw_main_menu);
+  while (oled_stream_busy) {};
+  prof_frame_cycles = PROFILE_SINCE(t0);
+}
+
+/*
+ * Measure the move generator, on a grid with a jagged stack
+ * and an overhang to tuck under. It runs a few times, and
+ * the average is kept. (This uses the game's grid, so it
+ * must run before the first game starts.)
+ */
+void profile_moves(void) {
+  static tetris_moves_t prof_moves;
+  static const uint16_t prof_rows[6] = {
+    0x3C0, 0x200, 0x231, 0x3B3, 0x3F7, 0x1FF
+  };
+  uint8_t grid_iy;
+  uint8_t run_i;
+  uint32_t t0;
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    tetris_game.rows[grid_iy] =
+      (grid_iy < 14) ? 0 : prof_rows[grid_iy - 14];
+  }
+  tetris_game.cur.type = TBRICK_T;
+  tetris_game.cur.x = BRICK_SPAWN_X[TBRICK_T];
+  tetris_game.cur.y = BRICK_SPAWN_Y[TBRICK_T];
+  tetris_game.cur.r = 0;
+  t0 = PROFILE_NOW();
+  for (run_i = 0; run_i < 8; ++run_i) {
+    prof_moves_found = tetris_gen_moves(&prof_moves, &tetris_game);
+  }
+  prof_moves_cycles = PROFILE_SINCE(t0) / 8;
+  tetris_reset_board(&tetris_game);
+}
+#endif
+
+/*
+ * Set the SSD1331's column / row address window. Pixel data
+ * which follows fills the window left-to-right, top-to-bottom.
+ */
+void ssd1331_set_window(uint8_t x0, uint8_t y0,
+                        uint8_t x1, uint8_t y1) {
+  // 'Set Column Address'
+  oled_cmd(0x15);
+  oled_cmd(x0);
+  oled_cmd(x1);
+  // 'Set Row Address'
+  oled_cmd(0x75);
+  oled_cmd(y0);
+  oled_cmd(y1);
+}
+
+/*
+ * Send a region of the framebuffer's current band to the
+ * display, after its address window has been set. 'x0' must
+ * be even and 'x1' odd, to cover whole framebuffer bytes.
+ */
+static void oled_stream_rect(uint8_t x0, uint8_t y0,
+                             uint8_t x1, uint8_t y1) {
+#ifdef VVC_HSPI
+  // Hand the region off to the SPI1 peripheral's DMA channel.
+  hspi_stream_rect(x0, y0, x1, y1);
+#else
   uint16_t px_i = 0;
-  uint16_t px_val = 0;
-  uint8_t px_col = 0;
-  // Draw the buffer.
-  for (px_i = 0; px_i < OLED_FB_SIZE; ++px_i) {
-    px_col = oled_fb[px_i] >> 4;
-    px_val = oled_colors[px_col];
-    sspi_w(px_val >> 8);
-    sspi_w(px_val & 0x00FF);
-    px_col = oled_fb[px_i] & 0x0F;
-    px_val = oled_colors[px_col];
-    sspi_w(px_val >> 8);
-    sspi_w(px_val & 0x00FF);
+  uint16_t px_row_end = 0;
+  uint32_t px_vals = 0;
+  uint8_t y_pos;
+  // Draw the buffer, one row at a time.
+  for (y_pos = y0 - oled_band_y; y_pos <= y1 - oled_band_y; ++y_pos) {
+    px_row_end = (x1 + (y_pos * 96)) / 2;
+    for (px_i = (x0 + (y_pos * 96)) / 2; px_i <= px_row_end; ++px_i) {
+      px_vals = oled_expand(oled_fb[px_i]);
+      sspi_w(px_vals & 0xFF);
+      sspi_w((px_vals >> 8) & 0xFF);
+      sspi_w((px_vals >> 16) & 0xFF);
+      sspi_w(px_vals >> 24);
+    }
+  }
+#endif
+}
+
+#ifndef VVC_OLED_SCANLINE
+/*
+ * Send the dirty regions of the framebuffer to the display.
+ * Each region is widened to whole framebuffer bytes (even
+ * starting / odd ending columns) so that it can be streamed
+ * two pixels at a time.
+ */
+void sspi_stream_framebuffer(void) {
+  uint8_t rect_i;
+  uint8_t x0, y0, x1, y1;
+  for (rect_i = 0; rect_i < oled_num_dirty; ++rect_i) {
+    x0 = oled_dirty[rect_i].x0 & ~(0x01);
+    x1 = oled_dirty[rect_i].x1 | 0x01;
+    y0 = oled_dirty[rect_i].y0;
+    y1 = oled_dirty[rect_i].y1;
+    // (This waits for any previous region to finish sending.)
+    ssd1331_set_window(x0, y0, x1, y1);
+    oled_stream_rect(x0, y0, x1, y1);
+  }
+  oled_num_dirty = 0;
+}
+
+/*
+ * Draw a frame into the framebuffer, and send the parts
+ * of it which changed to the display.
+ */
+void oled_render_frame(void (*draw_fn)(void)) {
+  draw_fn();
+  sspi_stream_framebuffer();
+}
+#else
+/*
+ * Scanline renderer: draw and send a frame one band of rows
+ * at a time, so that no full framebuffer is needed. The
+ * drawing method is called once per band; the drawing
+ * primitives skip anything outside of the band. The address
+ * window is set once, and the display fills it in order.
+ */
+void oled_render_frame(void (*draw_fn)(void)) {
+  uint8_t band_y;
+  uint16_t buf_i;
+  ssd1331_set_window(0, 0, 95, 63);
+  for (band_y = 0; band_y < 64; band_y += OLED_BAND_ROWS) {
+    // Wait for the previous band to finish sending.
+    while (oled_stream_busy) {};
+    oled_band_y = band_y;
+    for (buf_i = 0; buf_i < OLED_BUF_SIZE; ++buf_i) {
+      oled_fb[buf_i] = 0x00;
+    }
+    // (Make screens redraw everything in each band.)
+    oled_fb_screen = OLED_SCREEN_NONE;
+    draw_fn();
+    oled_stream_rect(0, band_y, 95, band_y + OLED_BAND_ROWS - 1);
   }
 }
+#endif
+
+/*
+ * Fill the screen; shown for unknown game states.
+ */
+void draw_blank_screen(void) {
+  oled_fb_screen = OLED_SCREEN_NONE;
+  oled_draw_rect(0, 0, 96, 64, 0, 1);
+}
 
 void draw_main_menu(void) {
+  oled_fb_screen = GAME_STATE_MAIN_MENU;
   oled_draw_rect(0, 0, 96, 64, 0, 0);
   oled_draw_rect(0, 0, 96, 64, 2, 1);
   // Draw a big 'TETRIS' in the top-middle.
@@ -707,6 +1020,7 @@ void draw_main_menu(void) {
 }
 
 void draw_game_over(void) {
+  oled_fb_screen = GAME_STATE_GAME_OVER;
   oled_draw_rect(0, 0, 96, 64, 0, 0);
   oled_draw_rect(0, 0, 96, 64, 2, 1);
   // Draw a bit 'GAME OVER' label.
@@ -714,63 +1028,180 @@ void draw_game_over(void) {
   oled_draw_text(24, 36, "OVER\0", 8, 'L');
 }
 
+/*
+ * Take the snapshot of the current brick, and where it would
+ * land, that 'draw_tetris_game' draws from. The button
+ * interrupts can move the brick at any time, so this masks
+ * them; with the scanline renderer, every band of a frame is
+ * then drawn with the brick in the same place.
+ */
+void snapshot_tetris_game(void) {
+  __disable_irq();
+  draw_piece = tetris_game.cur;
+  draw_ghost_y = tetris_landing_row(&tetris_game);
+  __enable_irq();
+}
+
+/*
+ * Draw the in-game screen, in layers. The static layer (the
+ * border, grid lines and labels) is only drawn when the screen
+ * is first entered. After that, only the playfield cells whose
+ * color changed since they were last drawn are redrawn, and
+ * the score, level and 'next brick' preview are only redrawn
+ * when their values change. (The scanline renderer redraws
+ * every layer in each band, so it keeps no record of what
+ * was last drawn.)
+ */
 void draw_tetris_game(void) {
-  oled_draw_rect(0, 0, 96, 64, 0, 0);
-  oled_draw_rect(0, 0, 96, 64, 2, 1);
-  // Draw a test grid, 10x20 @3 square pixels.
+#ifndef VVC_OLED_SCANLINE
+  static uint32_t hud_score = 0;
+  static uint8_t hud_level = 0;
+  static uint8_t hud_next = 0;
+  // Color of each playfield cell, as it was last drawn.
+  static uint8_t drawn_cells[10][20];
+#endif
+  uint8_t redraw_all = 0;
+  uint8_t new_score, new_level, new_next;
   uint8_t grid_ix = 0;
   uint8_t grid_iy = 0;
-  // Vertical 'column' lines.
-  for (grid_ix = 0; grid_ix < 11; ++grid_ix) {
-    oled_draw_v_line(32 + (grid_ix * 3), 2, 60, 14);
+  int8_t brick_ix = 0;
+  int8_t brick_iy = 0;
+  if (oled_fb_screen != GAME_STATE_IN_GAME) {
+    oled_fb_screen = GAME_STATE_IN_GAME;
+    redraw_all = 1;
+  }
+#ifdef OLED_HW_ACCEL
+  if (!redraw_all && tetris_game.cleared_rows &&
+      !(tetris_game.cleared_rows & TETRIS_ROWS_UNKNOWN)) {
+    // Rows were cleared; instead of redrawing the stack,
+    // shift it down on the display itself. Contiguous runs
+    // of cleared rows move everything above them down by
+    // 3px per row, working from the top run down. (The grid
+    // line under the run is left out, so that nothing lands
+    // on the border.) The rows exposed at the top are then
+    // fixed up below.
+    uint8_t run_top = 0;
+    uint8_t run_len = 0;
+    int8_t shift_iy;
+    for (grid_iy = 0; grid_iy <= 20; ++grid_iy) {
+      if ((grid_iy < 20) && (tetris_game.cleared_rows & (1UL << grid_iy))) {
+        if (!run_len) { run_top = grid_iy; }
+        ++run_len;
+      }
+      else if (run_len) {
+        if (run_top > 0) {
+          oled_shift_down(32, 3, 63, 1 + (run_top * 3), run_len * 3);
+          // (The drawn cells moved along with the pixels.)
+          for (shift_iy = run_top - 1; shift_iy >= 0; --shift_iy) {
+            for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+              drawn_cells[grid_ix][shift_iy + run_len] =
+                drawn_cells[grid_ix][shift_iy];
+            }
+          }
+        }
+        run_len = 0;
+      }
+    }
   }
-  // Horizontal 'row' lines.
-  for (grid_iy = 0; grid_iy < 21; ++grid_iy) {
-    oled_draw_h_line(33, 2 + (grid_iy * 3), 29, 14);
+#endif
+  tetris_game.cleared_rows = 0;
+
+  // Static layer.
+  if (redraw_all) {
+    oled_draw_rect(0, 0, 96, 64, 0, 0);
+    oled_draw_rect(0, 0, 96, 64, 2, 1);
+    // Vertical 'column' lines.
+    for (grid_ix = 0; grid_ix < 11; ++grid_ix) {
+      oled_draw_v_line(32 + (grid_ix * 3), 2, 60, 14);
+    }
+    // Horizontal 'row' lines.
+    for (grid_iy = 0; grid_iy < 21; ++grid_iy) {
+      oled_draw_h_line(33, 2 + (grid_iy * 3), 29, 14);
+    }
   }
 
-  // Draw the grid.
+  // Playfield layer: the grid, with the current brick and
+  // its 'ghost' (where it would land) on top.
+  uint8_t cell_type = 0;
   uint8_t cell_col = 0;
   for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
     for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
-      // For monochrome displays, just check empty/not empty.
-      if (tetris_grid[grid_ix][grid_iy] != TGRID_EMPTY) {
-        cell_col = tetris_grid[grid_ix][grid_iy] + 4;
-        oled_draw_rect(33 + (grid_ix * 3),
-                       3 + (grid_iy * 3),
-                       2, 2, 0, cell_col);
+      if (!oled_band_hit(3 + (grid_iy * 3), 2)) { continue; }
+      cell_type = tetris_game.grid[grid_ix][grid_iy];
+      brick_ix = grid_ix - draw_piece.x;
+      brick_iy = grid_iy - draw_piece.y;
+      if ((brick_ix >= 0) && (brick_ix < 4) &&
+          (brick_iy >= 0) && (brick_iy < 4) &&
+          (BRICK_ROWS[draw_piece.r][draw_piece.type][brick_iy] & (1 << brick_ix))) {
+        cell_type = draw_piece.type;
       }
-    }
-  }
-
-  // Draw the current brick.
-  for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
-    for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
-      if ((cur_block_y+grid_iy >= 0) &&
-          (BRICKS[cur_block_r][cur_block_type] & (1 << (3-grid_ix+(3-grid_iy)*4)))) {
-        cell_col = cur_block_type + 4;
-        oled_draw_rect(33 + ((cur_block_x+grid_ix) * 3),
-                       3 + ((cur_block_y+grid_iy) * 3),
-                       2, 2, 0, cell_col);
+      cell_col = 0;
+      if (cell_type != TGRID_EMPTY) {
+        cell_col = cell_type + 4;
+      }
+      else {
+        brick_iy = grid_iy - draw_ghost_y;
+        if ((brick_ix >= 0) && (brick_ix < 4) &&
+            (brick_iy >= 0) && (brick_iy < 4) &&
+            (BRICK_ROWS[draw_piece.r][draw_piece.type][brick_iy] & (1 << brick_ix))) {
+          cell_col = TGRID_GHOST_COL;
+        }
       }
+#ifndef VVC_OLED_SCANLINE
+      if (!redraw_all && drawn_cells[grid_ix][grid_iy] == cell_col) {
+        continue;
+      }
+      drawn_cells[grid_ix][grid_iy] = cell_col;
+#endif
+      oled_draw_rect(33 + (grid_ix * 3),
+                     3 + (grid_iy * 3),
+                     2, 2, 0, cell_col);
     }
   }
 
-  // Draw the left sidebar (points, level)
-  oled_draw_text(7, 4, "Pts\0", 1, 'S');
-  oled_draw_letter_i(7, 14, tetris_score, 1, 'S');
-  oled_draw_text(7, 34, "Lvl\0", 1, 'S');
-  oled_draw_letter_i(7, 44, tetris_level, 1, 'S');
-
-  // Draw the right sidebar ('next brick' display)
-  oled_draw_text(67, 8, "Next\0", 1, 'S');
-  oled_draw_text(64, 20, "Brick\0", 1, 'S');
-  // Draw the brick.
-  for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
-    for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
-      if (BRICKS[0][next_block_type] & (1 << (3-grid_ix+(3-grid_iy)*4))) {
-        // If the current square is occupied, draw it.
-        cell_col = next_block_type + 4;
+  // HUD layer: the left sidebar (points, level)
+  new_score = redraw_all;
+  new_level = redraw_all;
+  new_next = redraw_all;
+#ifndef VVC_OLED_SCANLINE
+  if (hud_score != tetris_game.score) {
+    hud_score = tetris_game.score;
+    new_score = 1;
+  }
+  if (hud_level != tetris_game.level) {
+    hud_level = tetris_game.level;
+    new_level = 1;
+  }
+  if (hud_next != tetris_game.next_type) {
+    hud_next = tetris_game.next_type;
+    new_next = 1;
+  }
+#endif
+  if (redraw_all) {
+    oled_draw_text(7, 4, "Pts\0", 1, 'S');
+    oled_draw_text(7, 34, "Lvl\0", 1, 'S');
+  }
+  if (new_score) {
+    oled_draw_rect(2, 14, 30, 8, 0, 0);
+    oled_draw_bcd(7, 14, tetris_game.score, 1, 'S');
+  }
+  if (new_level) {
+    oled_draw_rect(2, 44, 30, 8, 0, 0);
+    oled_draw_bcd(7, 44, tetris_game.level, 1, 'S');
+  }
+  // ...and the right sidebar ('next brick' display)
+  if (redraw_all) {
+    oled_draw_text(67, 8, "Next\0", 1, 'S');
+    oled_draw_text(64, 20, "Brick\0", 1, 'S');
+  }
+  if (new_next) {
+    // Draw the brick, clearing the unoccupied squares.
+    for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
+      for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
+        cell_col = 0;
+        if (BRICK_ROWS[0][tetris_game.next_type][grid_iy] & (1 << grid_ix)) {
+          cell_col = tetris_game.next_type + 4;
+        }
         oled_draw_rect(74 + (grid_ix * 4), 40 + (grid_iy * 4), 3, 3, 0, cell_col);
       }
     }
@@ -784,165 +1215,141 @@ void reset_game_state(void) {
   // Reset global states.
   should_tick = 0;
   state_changed = 1;
-  fast_tick_timer_on = 0;
-  left_right_fast_tick = 0;
-  game_tick_prescaler = 1024;
-  game_tick_period = 46785;
-  // Reset the 'current block' position.
-  cur_block_x = 4;
-  cur_block_y = -1;
-  cur_block_r = 0;
-  // Clear the grid memory.
-  uint8_t grid_ix = 0;
-  uint8_t grid_iy = 0;
-  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
-    for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
-      tetris_grid[grid_ix][grid_iy] = TGRID_EMPTY;
-    }
-  }
+  tetris_frame_reset(&game_timing, 0);
+  // Empty the grid and put the current brick back at the top.
+  tetris_reset_board(&tetris_game);
 }
 
 /*
- * Check whether the current brick can rotate into a given
- * position. Return 1 if there is a collision, 0 if it can rotate.
+ * Run the game's timing for one frame slot: gravity, lock
+ * delay, and the buttons' auto-repeat, all counted in slots.
+ * (See 'tetris_frame_step') The buttons are only read in a
+ * game that a player is playing. The button interrupts move
+ * the brick too, so they're masked while this runs.
  */
-uint8_t check_brick_rot(int8_t new_r) {
-  uint8_t grid_ix = 0;
-  uint8_t grid_iy = 0;
-  for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
-    for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
-      if ((cur_block_y+grid_iy >= 0) &&
-          (BRICKS[new_r][cur_block_type] & (1 << (3-grid_ix+(3-grid_iy)*4))) &&
-          ((cur_block_y+grid_iy > 19) ||
-           (cur_block_x+grid_ix < 0) ||
-           (cur_block_x+grid_ix > 9) ||
-           (tetris_grid[cur_block_x+grid_ix][cur_block_y+grid_iy] != TGRID_EMPTY))) {
-        return 1;
-      }
-    }
-  }
-  return 0;
+void game_frame(void) {
+  uint8_t held = 0;
+  if ((game_state != GAME_STATE_IN_GAME) &&
+      (game_state != GAME_STATE_ATTRACT)) {
+    return;
+  }
+  __disable_irq();
+  if (game_state == GAME_STATE_IN_GAME) {
+    if (!(GPIOB->IDR & GPIO_IDR_0)) { held |= TFRAME_HELD_DOWN; }
+    if (!(GPIOB->IDR & GPIO_IDR_1)) { held |= TFRAME_HELD_RIGHT; }
+    if (!(GPIOA->IDR & GPIO_IDR_6)) { held |= TFRAME_HELD_LEFT; }
+  }
+  tetris_frame_step(&game_timing, &tetris_game, held);
+  __enable_irq();
 }
 
+#ifdef VVC_REPLAY
 /*
- * Check whether the current brick can move into a
- * given grid coordinate.
- * Return 1 if there is a collision, 0 if the space is free.
+ * Read the frame scheduler's clock, in 10KHz ticks.
+ * (Read the slot count twice, in case it changes between
+ *  reading it and reading the counter.)
  */
-uint8_t check_brick_pos(int8_t xp, int8_t yp) {
-  uint8_t grid_ix = 0;
-  uint8_t grid_iy = 0;
-  for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
-    for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
-      if ((yp+grid_iy >= 0) &&
-          (BRICKS[cur_block_r][cur_block_type] & (1 << (3-grid_ix+(3-grid_iy)*4))) &&
-          ((yp+grid_iy > 19) || (xp+grid_ix < 0) ||
-           (xp+grid_ix > 9) ||
-           (tetris_grid[xp+grid_ix][yp+grid_iy] != TGRID_EMPTY))) {
-        return 1;
-      }
-    }
-  }
-  return 0;
+static uint32_t replay_frame_time(void) {
+  uint32_t slot;
+  uint16_t cnt;
+  do {
+    slot = frame_slot;
+    cnt = TIM17->CNT;
+  } while (slot != frame_slot);
+  return (slot * (FRAME_TIM_ARR + 1)) + cnt;
 }
 
 /*
- * Clear a row in the tetris grid, and shift the rows above down.
+ * Replay the last recorded game as fast as possible, drawing
+ * the playfield after every event. This gives a fixed
+ * workload for timing the game tick and the renderer.
  */
-void tetris_clear_row(uint8_t row_num) {
-  uint8_t grid_ix;
-  uint8_t grid_iy;
-  // For each row (starting at the row to clear,)
-  // replace it with the row above and move up 1.
-  for (grid_iy = row_num; grid_iy > 0; --grid_iy) {
-    for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
-      tetris_grid[grid_ix][grid_iy] = tetris_grid[grid_ix][grid_iy-1];
-    }
-  }
-  // For row 0, just set all cells to empty.
-  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
-    tetris_grid[grid_ix][0] = TGRID_EMPTY;
-  }
+void replay_benchmark(void) {
+  replay_reader_t reader;
+  uint32_t start_time = replay_frame_time();
+  replay_bench_events = 0;
+  replay_start(&reader, &replay_log);
+  while (replay_step(&reader, &tetris_game) != REPLAY_EV_END) {
+    ++replay_bench_events;
+    snapshot_tetris_game();
+    oled_render_frame(draw_tetris_game);
+  }
+  replay_bench_us = (replay_frame_time() - start_time) * 100;
 }
+#endif
 
 /*
- * Main 'tick' for the Tetris game loop.
- * This performs one 'step' in the game, either dropping a brick
- * or setting it in place and clearing rows/creating the next one.
+ * Start a game of attract mode, played by the computer.
  */
-void tetris_game_tick(void) {
-  int8_t grid_ix = 0;
-  int8_t grid_iy = 0;
-  unsigned char can_drop = 1;
-  /* Step 1:  Try to drop the current brick by 1 cell. */
-  if (check_brick_pos(cur_block_x, cur_block_y+1)) {
-    can_drop = 0;
-  }
+void attract_start(void) {
+  reset_game_state();
+  tetris_new_game(&tetris_game);
+  game_state = GAME_STATE_ATTRACT;
+  // (Make sure that the first brick gets a new search.)
+  attract_brick = tetris_game.brick_count - 1;
+  attract_rate_slot = frame_slot;
+  attract_rate_evals = attract_ai.evals;
+}
 
-  if (can_drop) {
-    /* Step 2a: If the current brick can drop, do so. */
-    cur_block_y++;
-  }
-  else {
-    /* Step 2b: If the current brick cannot drop, fix it
-     *          in the main Tetris grid. */
-    for (grid_ix = 0; grid_ix < 4; ++grid_ix) {
-      for (grid_iy = 0; grid_iy < 4; ++grid_iy) {
-        if (BRICKS[cur_block_r][cur_block_type] & (1 << (3-grid_ix+(3-grid_iy)*4))) {
-          if (cur_block_y+grid_iy < 0) {
-            // Game over
-            game_state = GAME_STATE_GAME_OVER;
-            uled_state = 0;
-            stop_timer(TIM2);
-          }
-          else {
-            tetris_grid[cur_block_x+grid_ix][cur_block_y+grid_iy] = cur_block_type;
-          }
-        }
+/*
+ * Run attract mode; called from the main loop.
+ * Each new brick starts a search, which only runs until the
+ * frame slot's share of time for it has been used up, so it
+ * can take several slots. Once it's done, the brick makes one
+ * move per slot towards the chosen placement: rotate, then
+ * slide, then drop. If a move is blocked, it drops early.
+ */
+void attract_step(void) {
+  int8_t new_r;
+  // Once a second, work out how fast the search is going.
+  if (frame_slot - attract_rate_slot >= VVC_FRAME_HZ) {
+    ai_evals_per_sec = attract_ai.evals - attract_rate_evals;
+    attract_rate_evals = attract_ai.evals;
+    attract_rate_slot = frame_slot;
+  }
+  // (Wait for the last drop to be locked in.)
+  if (should_tick) { return; }
+  if (attract_brick != tetris_game.brick_count) {
+    attract_brick = tetris_game.brick_count;
+    tetris_ai_start(&attract_ai, tetris_game.rows,
+                    tetris_game.cur.type, tetris_game.next_type);
+  }
+  if (!attract_ai.done) {
+    // The search gets 'AI_SLICE_TICKS' from the first time it
+    // runs in a frame slot, however late in the slot that is,
+    // but never past the end of the slot.
+    if (attract_slice_slot != frame_slot) {
+      attract_slice_slot = frame_slot;
+      attract_slice_end = TIM17->CNT + AI_SLICE_TICKS;
+      if (attract_slice_end > FRAME_TIM_ARR) {
+        attract_slice_end = FRAME_TIM_ARR;
       }
     }
-
-    /* Step 3b: Clear any appropriate rows. */
-    grid_iy = 19;
-    uint8_t row_has_space = 0;
-    while (grid_iy >= 0) {
-      row_has_space = 0;
-      // If the row is full, clear it and move all the
-      // rows above it down by one.
-      for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
-        if (tetris_grid[grid_ix][grid_iy] == TGRID_EMPTY) {
-          row_has_space = 1;
-        }
-      }
-      if (!row_has_space) {
-        tetris_clear_row(grid_iy);
-        // Also increment the 'score' variable by 1.
-        tetris_score += 1;
-        // Increment the level every 10 points.
-        if (tetris_score % 5 == 0 && tetris_level < 10) {
-          tetris_level += 1;
-          // When the level increments, make the game's main
-          // 'tick' timer faster.
-          stop_timer(TIM2);
-          game_tick_period = 46785 - (3072 * tetris_level);
-          start_timer(TIM2, game_tick_prescaler,
-                      game_tick_period, 1);
-        }
-      }
-      // If not, move to the next row.
-      else {
-        grid_iy--;
-      }
+    while ((attract_slice_slot == frame_slot) &&
+           (TIM17->CNT < attract_slice_end)) {
+      if (tetris_ai_step(&attract_ai)) { break; }
     }
-
-    /* Step 4b: Create a new 'current brick'. */
-    uint8_t new_block_type = TIM3->CNT & 0x7;
-    // (Valid block types are between [0:6])
-    while (new_block_type == 7) { new_block_type = TIM3->CNT & 0x7; }
-    cur_block_type = next_block_type;
-    next_block_type = new_block_type;
-    cur_block_x = 4;
-    cur_block_y = -1;
-    cur_block_r = 0;
+    return;
+  }
+  if (attract_move_slot == frame_slot) { return; }
+  attract_move_slot = frame_slot;
+  new_r = (tetris_game.cur.r + 1) % 4;
+  if ((tetris_game.cur.r != attract_ai.best_r) && !check_brick_rot(&tetris_game, new_r)) {
+    tetris_game.cur.r = new_r;
   }
+  else if ((tetris_game.cur.x < attract_ai.best_x) &&
+           !check_brick_pos(&tetris_game, tetris_game.cur.x + 1,
+                            tetris_game.cur.y)) {
+    tetris_game.cur.x += 1;
+  }
+  else if ((tetris_game.cur.x > attract_ai.best_x) &&
+           !check_brick_pos(&tetris_game, tetris_game.cur.x - 1,
+                            tetris_game.cur.y)) {
+    tetris_game.cur.x -= 1;
+  }
+  else {
+    tetris_game.cur.y = tetris_landing_row(&tetris_game);
+    should_tick = 1;
+  }
+  state_changed = 1;
 }
@@ -3,17 +3,46 @@
 
 #include "global.h"
 #include "sspi.h"
+#include "hspi.h"
 #include "peripherals.h"
+#include "profile.h"
 
 // C-languages utility method signatures.
 
 // Methods for interacting with specific I2C devices.
 void ssd1306_start_sequence(I2C_TypeDef *I2Cx);
 void ssd1331_start_sequence();
+void ssd1331_set_window(uint8_t x0, uint8_t y0,
+                        uint8_t x1, uint8_t y1);
+#ifdef OLED_HW_ACCEL
+// Accelerated drawing commands; these draw straight into the
+// display's RAM, so the framebuffer must be updated to match.
+void ssd1331_draw_line(uint8_t x0, uint8_t y0,
+                       uint8_t x1, uint8_t y1,
+                       uint16_t color);
+void ssd1331_draw_rect(uint8_t x0, uint8_t y0,
+                       uint8_t x1, uint8_t y1,
+                       uint16_t color, uint8_t fill);
+void ssd1331_clear_window(uint8_t x0, uint8_t y0,
+                          uint8_t x1, uint8_t y1);
+void ssd1331_copy(uint8_t x0, uint8_t y0,
+                  uint8_t x1, uint8_t y1,
+                  uint8_t nx, uint8_t ny);
+void oled_shift_down(uint8_t x0, uint8_t y0,
+                     uint8_t x1, uint8_t y1, uint8_t dy);
+#endif
 
-// Methods for writing to the 1KB OLED framebuffer.
+// Methods for writing to the 3KB OLED framebuffer.
 // These don't actually write through to the screen until
-// the 'i2c_display_framebuffer' method is called (see util.S)
+// the 'sspi_stream_framebuffer' method is called; they only
+// mark the changed regions as 'dirty'.
+#ifdef VVC_OLED_SCANLINE
+  // (Every frame is sent in full; nothing to track.)
+  #define oled_mark_dirty(x0, y0, x1, y1) \
+    do { (void)(x0); (void)(y0); (void)(x1); (void)(y1); } while (0)
+#else
+void oled_mark_dirty(int x0, int y0, int x1, int y1);
+#endif
 void oled_draw_h_line(int x, int y, int w, uint8_t color);
 void oled_draw_v_line(int x, int y, int h, uint8_t color);
 void oled_draw_rect(int x, int y, int w, int h,
@@ -21,18 +50,53 @@ void oled_draw_rect(int x, int y, int w, int h,
 void oled_write_pixel(int x, int y, uint8_t color);
 void oled_draw_letter(int x, int y, unsigned int w0, unsigned int w1, uint8_t color, char size);
 void oled_draw_letter_c(int x, int y, char c, uint8_t color, char size);
-void oled_draw_letter_i(int x, int y, int ic, uint8_t color, char size);
+void oled_draw_bcd(int x, int y, uint32_t bcd, uint8_t color, char size);
 void oled_draw_text(int x, int y, char* cc, uint8_t color, char size);
 void sspi_stream_framebuffer(void);
+void oled_render_frame(void (*draw_fn)(void));
+void oled_init_palette(void);
+void oled_set_color(uint8_t idx, uint16_t color);
+#ifdef VVC_PROFILE
+void oled_profile_expand(void);
+void oled_profile_fill(void);
+void oled_profile_frame(void);
+void profile_moves(void);
+#endif
+
+/*
+ * Check whether rows [y, y+h) overlap the framebuffer's
+ * current band, so drawing methods can skip work early.
+ */
+static inline uint8_t oled_band_hit(int y, int h) {
+  return ((y < oled_band_y + OLED_BAND_ROWS) &&
+          (y + h > oled_band_y));
+}
+
+/*
+ * Expand one framebuffer byte into its 4 display bytes,
+ * packed in wire order. (Byte 0 is sent first.)
+ */
+static inline uint32_t oled_expand(uint8_t px_byte) {
+#ifdef OLED_EXPAND_LUT
+  return oled_expand_lut[px_byte];
+#else
+  return (oled_expand_lut[px_byte >> 4] |
+          ((uint32_t)oled_expand_lut[px_byte & 0x0F] << 16));
+#endif
+}
 
 // Tetris methods!
 void draw_main_menu(void);
 void draw_game_over(void);
+void snapshot_tetris_game(void);
 void draw_tetris_game(void);
+void draw_blank_screen(void);
 void reset_game_state(void);
-uint8_t check_brick_rot(int8_t new_r);
-uint8_t check_brick_pos(int8_t xp, int8_t yp);
-void tetris_clear_row(uint8_t row_num);
-void tetris_game_tick(void);
+void game_frame(void);
+void attract_start(void);
+void attract_step(void);
+#ifdef VVC_REPLAY
+void replay_benchmark(void);
+#endif
 
 #endif
@@ -0,0 +1,57 @@
+// Generated by tools/gen_zobrist. Do not edit.
+#ifndef _VVC_ZOBRIST_H
+#define _VVC_ZOBRIST_H
+
+// A random key for each grid cell; a grid's hash is the
+// XOR of the keys of its filled cells.
+// Indices: [ row ], [ column ].
+static const uint32_t ZOBRIST_CELLS[20][10] = {
+  { 0x510C4619, 0xE02E553E, 0x7BB98F3A, 0x0183A8B5, 0xE6336D1F,
+    0xF989D237, 0xBA2529D0, 0xFCFBEDBF, 0xA8C5EE39, 0xB55A53B8 },
+  { 0x1A88A9EE, 0xF918A8B4, 0x6DC588D3, 0x472F513C, 0x0C1870B8,
+    0x43E1465F, 0x0E78EA8A, 0x761DC0DE, 0x0ECA9C7D, 0xF5E7493F },
+  { 0x84D44CBF, 0xA536E9DE, 0x79AFAED8, 0x02E9F4A2, 0xB3C8F91C,
+    0x318EC249, 0xD13543EA, 0x504FD68E, 0xF9563BE1, 0xFB6A9A74 },
+  { 0xACAD82A6, 0x83D0D79A, 0xBD58BA6B, 0xE8A46341, 0xFD4255C7,
+    0x48A7297A, 0x1C8FC87E, 0x558F2D7E, 0xB43618AE, 0x935F84DF },
+  { 0x1B4EF29D, 0x66BB3273, 0x1E5F1329, 0x7B73EBB4, 0xC6A87E76,
+    0xE5BD8265, 0xEBD01B3D, 0xFE4E23A6, 0x7D6529DB, 0xD39A9B74 },
+  { 0x9E7F3ACE, 0x5DFE0DFD, 0x147D987D, 0x493F1344, 0xC1AF1B0F,
+    0x7B13A768, 0xF02AB277, 0x6AE429E5, 0x14C73F29, 0x976EB1B8 },
+  { 0x6A6BB394, 0x9F3E8E98, 0x9358942E, 0xBA7F8CC0, 0x37128F53,
+    0xB9E359CF, 0x8980C4E2, 0xB28541EC, 0x4DA15AB0, 0xB81A50AB },
+  { 0xB3E67C2C, 0xF01B81BD, 0x85A054CB, 0x681719B7, 0xEF1638C7,
+    0x29D754C0, 0xAAA99987, 0xAABF9C2B, 0x7E60C676, 0xB3689101 },
+  { 0x8854D505, 0x4C7BF39F, 0x730959FB, 0x5EF4A9E0, 0xB2D14C84,
+    0xF371A5A4, 0x3F6D8E86, 0x591C32D8, 0x37ACF21B, 0x94171B6C },
+  { 0x982EBAF1, 0xA1671469, 0x3EA8A61C, 0x670D5609, 0x744E0D0F,
+    0x081948F8, 0x01CD571B, 0xCEE2330C, 0x98FD1EED, 0x5F34CCDD },
+  { 0x134EFECA, 0x5E6CC8A1, 0x2869E8BD, 0xBAB60242, 0x2531989D,
+    0xD264420C, 0x1E980CDE, 0xFF7BA8BF, 0xC7EDBCA9, 0x7F6C3635 },
+  { 0xCCF7B6E0, 0x7F5ED555, 0x1B70D24F, 0x261F68B3, 0xAA24CBD7,
+    0x58987D78, 0xB1DD8A83, 0x1130B265, 0xE8FE2ABB, 0x9882D18F },
+  { 0x94D94A16, 0x0EE14FBB, 0xC5D1BA30, 0xA06FAC1B, 0xE8703B4D,
+    0x0C2474E1, 0xD5BAA21D, 0xBED11EC1, 0x3C2778E5, 0xB44D9E78 },
+  { 0xF7D12A99, 0x82CE18D8, 0x7B723E72, 0xAB3065AC, 0x57337BAE,
+    0x3092562D, 0x30AEABC6, 0x5F153C8D, 0xE818F92F, 0x10913491 },
+  { 0xF662FD90, 0x93C58678, 0x4258685D, 0xA52E1174, 0x8714FC74,
+    0x0BD47719, 0x23D5A5C2, 0x7AD860F4, 0xAE1DA977, 0x7D5BD92E },
+  { 0xC9BD5831, 0x35D264EC, 0x50B4D12B, 0x98AB5803, 0x86C37B16,
+    0xDD983706, 0xB46BCDFA, 0x77498910, 0x8B1EEE85, 0x8F02D9A2 },
+  { 0x52E88499, 0x0D0B3124, 0x0EDF12D3, 0x7C2596B1, 0x1089E8C8,
+    0x9F8F3E00, 0x71AF46C7, 0xB78AA5FC, 0x859FD8A6, 0xAFEFDB83 },
+  { 0xC76DA84C, 0x3EE63EBE, 0xDF01C6E6, 0x1C73D408, 0xB8AE0951,
+    0x4906A7F3, 0x22E9A8EF, 0xE97C21B5, 0xC41C5510, 0x99703BAF },
+  { 0x5EB7010D, 0x6C493686, 0x19A3AA8A, 0xF2A94293, 0x8592B22E,
+    0xA9346365, 0x8E42E8E9, 0xB8AB8986, 0xFAFE842B, 0x6505D3D6 },
+  { 0x3090F149, 0xF98104B5, 0xFBEECFFE, 0x6032C036, 0x3EB799AC,
+    0x7DCD92CD, 0x3D1EF5E7, 0x97EEE2F6, 0x3DB0E2EE, 0x1C4B7118 }
+};
+// A key for each type of brick still to be placed, and
+// one for none. ('TT_NO_BRICK')
+static const uint32_t ZOBRIST_TYPES[8] = {
+  0x3F614DAC, 0xCC4C1E06, 0xBE13C1C0, 0x035FF875,
+  0x7675EDFD, 0xB28F2B18, 0xAA6C1D2E, 0x10F0F08A
+};
+
+#endif
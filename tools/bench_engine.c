@@ -0,0 +1,196 @@
+/*
+ * Host-side benchmark for the game engine. (src/tetris.c)
+ * Plays seeded games with a simple 'drop it as low as it
+ * will go' placement rule, letting every brick fall one
+ * gravity tick at a time, and reports the engine's ticks,
+ * locks and line clears per second. The row compaction is
+ * then timed on its own, with 4 full rows every time, and
+ * the move generator on every new brick from some games.
+ *
+ *   make bench                       Build and run it
+ *   ./tools/bench_engine [games] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tetris_moves.h"
+
+// Stop each game after this many bricks, if it lasts that long.
+#define BENCH_MAX_BRICKS (2000)
+// Number of compaction passes to time.
+#define BENCH_COMPACTS (2000000)
+// Number of positions to run the move generator on, and how
+// many times to go over them.
+#define BENCH_MOVE_POSITIONS (4096)
+#define BENCH_MOVE_PASSES    (20)
+
+// Platform interface: no timers, and seeds from a counter.
+// (Game over is read from the game's own flag.)
+static uint32_t bench_seed;
+static tetris_game_t bench_game;
+
+uint32_t tetris_plat_rng_seed(void) {
+  return bench_seed++;
+}
+
+void tetris_plat_set_speed(uint8_t level) {
+  (void)level;
+}
+
+void tetris_plat_game_over(void) {
+}
+
+/*
+ * Seconds on the monotonic clock.
+ */
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+/*
+ * Move the new brick to the rotation and column where it
+ * would land the lowest. (Ties go to the first one found.)
+ */
+static void bench_place_brick(tetris_game_t* g) {
+  int8_t best_r = 0;
+  int8_t best_x = g->cur.x;
+  int8_t best_y = -1;
+  int8_t land_y;
+  int8_t r;
+  int8_t x;
+  for (r = 0; r < 4; ++r) {
+    for (x = -3; x < 10; ++x) {
+      g->cur.r = r;
+      g->cur.x = x;
+      if (check_brick_pos(g, x, g->cur.y)) { continue; }
+      land_y = tetris_landing_row(g);
+      if (land_y > best_y) {
+        best_y = land_y;
+        best_r = r;
+        best_x = x;
+      }
+    }
+  }
+  g->cur.r = best_r;
+  g->cur.x = best_x;
+}
+
+/*
+ * Play one game, and add up what happened in it.
+ */
+static void bench_play_game(tetris_game_t* g, uint64_t* ticks,
+                            uint64_t* locks, uint64_t* lines) {
+  int8_t old_y;
+  uint32_t bricks = 0;
+  tetris_new_game(g);
+  bench_place_brick(g);
+  while (!g->game_over && bricks < BENCH_MAX_BRICKS) {
+    old_y = g->cur.y;
+    tetris_game_tick(g);
+    ++(*ticks);
+    // (A brick which can't drop is locked, and the next
+    //  one starts back at the top.)
+    if (g->cur.y <= old_y) {
+      ++(*locks);
+      ++bricks;
+      bench_place_brick(g);
+    }
+  }
+  // (The score goes up by 1 for each cleared row.)
+  *lines += tetris_bcd_value(g->score);
+}
+
+/*
+ * Time 'tetris_compact_rows' clearing the bottom 4 rows from
+ * under a partly-filled stack.
+ */
+static double bench_compact(tetris_game_t* g) {
+  uint32_t cleared_mask;
+  uint32_t rows = 0;
+  uint32_t i;
+  uint8_t grid_iy;
+  double start = bench_now();
+  for (i = 0; i < BENCH_COMPACTS; ++i) {
+    for (grid_iy = 8; grid_iy < 20; ++grid_iy) {
+      g->rows[grid_iy] = (grid_iy < 16) ? 0x1EF : TROW_FULL;
+    }
+    rows += tetris_compact_rows(g, &cleared_mask);
+  }
+  return rows / (bench_now() - start);
+}
+
+/*
+ * Time 'tetris_gen_moves' on each new brick of some games. The
+ * positions are saved first, so that playing them isn't timed.
+ * Returns the placements found per second, and sets
+ * 'max_found' to the most found for one brick.
+ */
+static double bench_moves(tetris_game_t* g, uint32_t* max_found) {
+  static tetris_game_t positions[BENCH_MOVE_POSITIONS];
+  static tetris_moves_t mv;
+  uint64_t found = 0;
+  uint32_t num = 0;
+  uint32_t bricks;
+  uint32_t pass_i;
+  uint32_t pos_i;
+  int8_t old_y;
+  double start;
+  while (num < BENCH_MOVE_POSITIONS) {
+    tetris_new_game(g);
+    positions[num++] = *g;
+    bench_place_brick(g);
+    bricks = 0;
+    while (!g->game_over && bricks < BENCH_MAX_BRICKS &&
+           num < BENCH_MOVE_POSITIONS) {
+      old_y = g->cur.y;
+      tetris_game_tick(g);
+      if (g->cur.y <= old_y) {
+        ++bricks;
+        if (!g->game_over) { positions[num++] = *g; }
+        bench_place_brick(g);
+      }
+    }
+  }
+  *max_found = 0;
+  start = bench_now();
+  for (pass_i = 0; pass_i < BENCH_MOVE_PASSES; ++pass_i) {
+    for (pos_i = 0; pos_i < num; ++pos_i) {
+      found += tetris_gen_moves(&mv, &positions[pos_i]);
+      if (mv.count > *max_found) { *max_found = mv.count; }
+    }
+  }
+  return found / (bench_now() - start);
+}
+
+int main(int argc, char** argv) {
+  uint32_t games = 5000;
+  uint32_t game_i;
+  uint64_t ticks = 0;
+  uint64_t locks = 0;
+  uint64_t lines = 0;
+  uint32_t max_found;
+  double start;
+  double secs;
+  double rate;
+  if (argc > 1) { games = strtoul(argv[1], NULL, 0); }
+  if (argc > 2) { bench_seed = strtoul(argv[2], NULL, 0); }
+  start = bench_now();
+  for (game_i = 0; game_i < games; ++game_i) {
+    bench_play_game(&bench_game, &ticks, &locks, &lines);
+  }
+  secs = bench_now() - start;
+  printf("%u games, %llu ticks, %llu locks, %llu lines in %.3fs\n",
+         games, (unsigned long long)ticks,
+         (unsigned long long)locks, (unsigned long long)lines, secs);
+  printf("  ticks/s: %.0f\n", ticks / secs);
+  printf("  locks/s: %.0f\n", locks / secs);
+  printf("  lines/s: %.0f\n", lines / secs);
+  printf("Row compaction: %.0f rows cleared/s\n", bench_compact(&bench_game));
+  rate = bench_moves(&bench_game, &max_found);
+  printf("Move generator: %.0f placements/s (up to %u per brick)\n",
+         rate, max_found);
+  return 0;
+}
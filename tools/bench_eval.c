@@ -0,0 +1,123 @@
+/*
+ * Host-side benchmark for the batch grid evaluator.
+ * (tools/eval_batch.c) Scores a set of random grids with the
+ * plain C kernel and with the one picked for this CPU, checks
+ * that they agree, and reports grids per second for each.
+ *
+ *   make bench-eval                 Build and run it
+ *   ./tools/bench_eval [grids] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "eval_batch.h"
+
+// Number of times to score every grid.
+#define BENCH_PASSES (50)
+
+static uint32_t bench_rng;
+
+static uint32_t bench_rand(void) {
+  bench_rng ^= bench_rng << 13;
+  bench_rng ^= bench_rng >> 17;
+  bench_rng ^= bench_rng << 5;
+  return bench_rng;
+}
+
+/*
+ * Fill a grid with a stack of uneven columns, with about one
+ * cell in 8 left empty. (So there are holes and full rows.)
+ */
+static void bench_grid(uint16_t* rows) {
+  uint8_t max_height = bench_rand() % 17;
+  uint8_t height;
+  uint8_t grid_ix;
+  uint8_t grid_iy;
+  memset(rows, 0, 20 * sizeof(rows[0]));
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    height = bench_rand() % (max_height + 1);
+    for (grid_iy = 20 - height; grid_iy < 20; ++grid_iy) {
+      if (bench_rand() & 7) { rows[grid_iy] |= (1 << grid_ix); }
+    }
+  }
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+/*
+ * Score every batch 'BENCH_PASSES' times.
+ * Returns grids per second.
+ */
+static double bench_kernel(eval_batch_fn fn, const eval_batch_t* batches,
+                           eval_out_t* outs, uint32_t num_batches) {
+  uint32_t pass_i;
+  uint32_t batch_i;
+  double start = bench_now();
+  for (pass_i = 0; pass_i < BENCH_PASSES; ++pass_i) {
+    for (batch_i = 0; batch_i < num_batches; ++batch_i) {
+      fn(&batches[batch_i], &outs[batch_i]);
+    }
+  }
+  return ((double)num_batches * EVAL_LANES * BENCH_PASSES) /
+         (bench_now() - start);
+}
+
+int main(int argc, char** argv) {
+  eval_batch_t* batches;
+  eval_out_t* ref_outs;
+  eval_out_t* outs;
+  eval_batch_fn fn;
+  const char* name;
+  uint16_t rows[20];
+  uint32_t grids = 65536;
+  uint32_t num_batches;
+  uint32_t grid_i;
+  uint64_t holes = 0;
+  uint64_t lines = 0;
+  double ref_rate;
+  double rate;
+  bench_rng = 0x2545F491;
+  if (argc > 1) { grids = strtoul(argv[1], NULL, 0); }
+  if (argc > 2) { bench_rng = strtoul(argv[2], NULL, 0) | 1; }
+  num_batches = (grids + EVAL_LANES - 1) / EVAL_LANES;
+  batches = calloc(num_batches, sizeof(*batches));
+  ref_outs = calloc(num_batches, sizeof(*ref_outs));
+  outs = calloc(num_batches, sizeof(*outs));
+  if (!batches || !ref_outs || !outs) {
+    perror("calloc");
+    return 1;
+  }
+  for (grid_i = 0; grid_i < num_batches * EVAL_LANES; ++grid_i) {
+    bench_grid(rows);
+    eval_pack(&batches[grid_i / EVAL_LANES], grid_i % EVAL_LANES, rows);
+  }
+  grids = num_batches * EVAL_LANES;
+
+  ref_rate = bench_kernel(eval_batch_scalar, batches, ref_outs,
+                          num_batches);
+  for (grid_i = 0; grid_i < grids; ++grid_i) {
+    holes += ref_outs[grid_i / EVAL_LANES].holes[grid_i % EVAL_LANES];
+    lines += ref_outs[grid_i / EVAL_LANES].lines[grid_i % EVAL_LANES];
+  }
+  printf("%u grids; %.1f holes and %.2f full rows each\n", grids,
+         (double)holes / grids, (double)lines / grids);
+  printf("  scalar: %.0f grids/s\n", ref_rate);
+  fn = eval_batch_select(&name);
+  if (fn == eval_batch_scalar) {
+    printf("  (No faster kernel for this CPU.)\n");
+    return 0;
+  }
+  rate = bench_kernel(fn, batches, outs, num_batches);
+  printf("  %s: %.0f grids/s (%.1fx)\n", name, rate, rate / ref_rate);
+  if (memcmp(ref_outs, outs, num_batches * sizeof(*outs))) {
+    printf("The %s results don't match the scalar ones.\n", name);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Host-side benchmark for the framebuffer fill kernels.
+ * (src/oled_fill.c) Fills whole screens, random horizontal
+ * lines and random rectangles with the old per-pixel loop
+ * which 'oled_draw_h_line' used, and with 'oled_fill_rows',
+ * checks that both leave the same framebuffer behind, and
+ * reports the time per fill for each.
+ *
+ *   make bench-fill                 Build and run it
+ *   ./tools/bench_fill [shapes] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oled_fill.h"
+
+// Number of times to draw every set of shapes.
+#define BENCH_PASSES (200)
+// Number of whole-screen fills in the first set.
+#define BENCH_SCREENS (64)
+// Size of a full-screen framebuffer.
+#define BENCH_FB_SIZE ((96 * 64) / 2)
+
+typedef struct {
+  uint8_t x0;
+  uint8_t y0;
+  uint8_t x1;
+  uint8_t y1;
+  uint8_t color;
+} bench_shape_t;
+
+// (Volatile, like the firmware's framebuffer.)
+static volatile uint8_t ref_fb[BENCH_FB_SIZE] __attribute__((aligned(4)));
+static volatile uint8_t span_fb[BENCH_FB_SIZE] __attribute__((aligned(4)));
+
+static uint32_t bench_rng;
+
+static uint32_t bench_rand(void) {
+  bench_rng ^= bench_rng << 13;
+  bench_rng ^= bench_rng >> 17;
+  bench_rng ^= bench_rng << 5;
+  return bench_rng;
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+/*
+ * The per-pixel horizontal line loop which the span kernel
+ * replaced: a division and a read-modify-write per pixel.
+ */
+static void ref_h_line(int x, int y, int w, uint8_t color) {
+  int x_pos = x;
+  int line_end = x + w;
+  int fb_ind;
+  if (x > 95) { return; }
+  if (line_end > 96) { line_end = 96; }
+  for (x_pos = x; x_pos < line_end; ++x_pos) {
+    fb_ind = (x_pos + (y * 96)) / 2;
+    ref_fb[fb_ind] &= ~((0x0F) << (4 * !(x_pos % 2)));
+    ref_fb[fb_ind] |= (color & 0x0F) << (4 * !(x_pos % 2));
+  }
+}
+
+static void ref_fill(const bench_shape_t* shape) {
+  int y_pos;
+  for (y_pos = shape->y0; y_pos <= shape->y1; ++y_pos) {
+    ref_h_line(shape->x0, y_pos, shape->x1 - shape->x0 + 1,
+               shape->color);
+  }
+}
+
+static uint8_t span_fill(const bench_shape_t* shape,
+                         oled_rect_t* changed) {
+  return oled_fill_rows(span_fb, 0, shape->x0, shape->y0,
+                        shape->x1, shape->y1, shape->color, changed);
+}
+
+/*
+ * Pick a random shape, 'h' rows high. (Or 1 to 'h' rows.)
+ */
+static void bench_shape(bench_shape_t* shape, int h, uint8_t fixed_h) {
+  int x0 = bench_rand() % 96;
+  int x1 = bench_rand() % 96;
+  int tmp;
+  if (x1 < x0) { tmp = x0; x0 = x1; x1 = tmp; }
+  if (!fixed_h) { h = 1 + (bench_rand() % h); }
+  shape->x0 = x0;
+  shape->x1 = x1;
+  shape->y0 = bench_rand() % (65 - h);
+  shape->y1 = shape->y0 + h - 1;
+  shape->color = bench_rand() & 0x0F;
+}
+
+static uint8_t fb_pixel(volatile uint8_t* fb, int x, int y) {
+  return (fb[(x + (y * 96)) / 2] >> (4 * !(x % 2))) & 0x0F;
+}
+
+/*
+ * Draw each shape once with both methods, and check that the
+ * framebuffers match after every one, and that the area which
+ * 'oled_fill_rows' reports holds every pixel which changed.
+ * Returns 1 if they all do.
+ */
+static uint8_t bench_check(const bench_shape_t* shapes,
+                           uint32_t num_shapes) {
+  static uint8_t before[BENCH_FB_SIZE];
+  oled_rect_t changed;
+  uint8_t any;
+  uint32_t shape_i;
+  int x, y;
+  for (shape_i = 0; shape_i < num_shapes; ++shape_i) {
+    memcpy(before, (const uint8_t*)span_fb, BENCH_FB_SIZE);
+    ref_fill(&shapes[shape_i]);
+    any = span_fill(&shapes[shape_i], &changed);
+    if (memcmp((const uint8_t*)ref_fb, (const uint8_t*)span_fb,
+               BENCH_FB_SIZE)) {
+      printf("Shape %u: the framebuffers don't match.\n", shape_i);
+      return 0;
+    }
+    for (y = 0; y < 64; ++y) {
+      for (x = 0; x < 96; ++x) {
+        if (fb_pixel(span_fb, x, y) == fb_pixel(before, x, y)) {
+          continue;
+        }
+        if (!any || (x < changed.x0) || (x > changed.x1) ||
+            (y < changed.y0) || (y > changed.y1)) {
+          printf("Shape %u: pixel %d,%d changed outside of the "
+                 "reported area.\n", shape_i, x, y);
+          return 0;
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+/*
+ * Draw every shape 'BENCH_PASSES' times with one method.
+ * Returns nanoseconds per shape.
+ */
+static double bench_fills(const bench_shape_t* shapes,
+                          uint32_t num_shapes, uint8_t use_span) {
+  oled_rect_t changed;
+  uint32_t pass_i;
+  uint32_t shape_i;
+  double start = bench_now();
+  for (pass_i = 0; pass_i < BENCH_PASSES; ++pass_i) {
+    for (shape_i = 0; shape_i < num_shapes; ++shape_i) {
+      if (use_span) { span_fill(&shapes[shape_i], &changed); }
+      else { ref_fill(&shapes[shape_i]); }
+    }
+  }
+  return ((bench_now() - start) * 1e9) /
+         ((double)num_shapes * BENCH_PASSES);
+}
+
+/*
+ * Check and time one set of shapes.
+ * Returns 1 if both methods drew the same thing.
+ */
+static uint8_t bench_set(const char* name, const bench_shape_t* shapes,
+                         uint32_t num_shapes) {
+  uint64_t px = 0;
+  uint32_t shape_i;
+  double ref_ns;
+  double span_ns;
+  for (shape_i = 0; shape_i < num_shapes; ++shape_i) {
+    px += (shapes[shape_i].x1 - shapes[shape_i].x0 + 1) *
+          (shapes[shape_i].y1 - shapes[shape_i].y0 + 1);
+  }
+  memset((uint8_t*)ref_fb, 0, BENCH_FB_SIZE);
+  memset((uint8_t*)span_fb, 0, BENCH_FB_SIZE);
+  if (!bench_check(shapes, num_shapes)) { return 0; }
+  ref_ns = bench_fills(shapes, num_shapes, 0);
+  span_ns = bench_fills(shapes, num_shapes, 1);
+  printf("%s: %u, %.0f pixels each\n", name, num_shapes,
+         (double)px / num_shapes);
+  printf("  per-pixel: %.1f ns/fill\n", ref_ns);
+  printf("  span: %.1f ns/fill (%.1fx)\n", span_ns, ref_ns / span_ns);
+  if (memcmp((const uint8_t*)ref_fb, (const uint8_t*)span_fb,
+             BENCH_FB_SIZE)) {
+    printf("The %s framebuffers don't match.\n", name);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  bench_shape_t* shapes;
+  uint32_t num_shapes = 4096;
+  uint32_t shape_i;
+  bench_rng = 0x2545F491;
+  if (argc > 1) { num_shapes = strtoul(argv[1], NULL, 0); }
+  if (argc > 2) { bench_rng = strtoul(argv[2], NULL, 0) | 1; }
+  if (num_shapes < BENCH_SCREENS) { num_shapes = BENCH_SCREENS; }
+  shapes = calloc(num_shapes, sizeof(*shapes));
+  if (!shapes) {
+    perror("calloc");
+    return 1;
+  }
+
+  // Whole screens, alternating colors so every pixel changes.
+  for (shape_i = 0; shape_i < BENCH_SCREENS; ++shape_i) {
+    shapes[shape_i].x0 = 0;
+    shapes[shape_i].y0 = 0;
+    shapes[shape_i].x1 = 95;
+    shapes[shape_i].y1 = 63;
+    shapes[shape_i].color = 1 + (shape_i & 1);
+  }
+  if (!bench_set("Full screens", shapes, BENCH_SCREENS)) { return 1; }
+  for (shape_i = 0; shape_i < num_shapes; ++shape_i) {
+    bench_shape(&shapes[shape_i], 1, 1);
+  }
+  if (!bench_set("Lines", shapes, num_shapes)) { return 1; }
+  for (shape_i = 0; shape_i < num_shapes; ++shape_i) {
+    bench_shape(&shapes[shape_i], 16, 0);
+  }
+  if (!bench_set("Rectangles", shapes, num_shapes)) { return 1; }
+  return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * Host-side check for the game's frame timing.
+ * (src/tetris_frame.c) Runs 'tetris_frame_step' once per slot
+ * of a stub frame clock, the way 'game_frame' does on the
+ * board, and checks that bricks fall at each level's rate on
+ * 'GRAVITY_CURVE', that a landed brick locks after
+ * 'LOCK_DELAY_FRAMES' and not before, and that held buttons
+ * repeat after 'SHIFT_DELAY_FRAMES' and then every
+ * 'SHIFT_REPEAT_FRAMES'. It has to be built with the same
+ * 'FRAME_HZ' as the firmware.
+ *
+ *   make check-frame                 Build and run it
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tetris_frame.h"
+
+// Longest that any one check waits for something, in slots.
+#define CHECK_MAX_SLOTS (VVC_FRAME_HZ * 30)
+
+// Platform interface: the gravity goes in 'check_timing' like
+// it goes in 'game_timing' on the board, and every event from
+// the frame timing is counted along with the slot it was in.
+static tetris_frame_t check_timing;
+static tetris_game_t check_game;
+static uint32_t check_slot;
+static uint32_t check_events[4];
+static uint32_t check_event_slot[4];
+static uint32_t check_failures;
+
+uint32_t tetris_plat_rng_seed(void) {
+  return 1;
+}
+
+void tetris_plat_set_speed(uint8_t level) {
+  check_timing.gravity = GRAVITY_CURVE[level];
+}
+
+void tetris_plat_game_over(void) {
+}
+
+void tetris_plat_frame_event(uint8_t ev) {
+  ++check_events[ev];
+  check_event_slot[ev] = check_slot;
+}
+
+static void check_fail(const char* what, uint32_t a, uint32_t b) {
+  printf("  FAIL: %s (%u, expected %u)\n", what, a, b);
+  ++check_failures;
+}
+
+/*
+ * Start a new game at a level, with the clock at slot 0.
+ */
+static void check_start(uint32_t seed, uint8_t level) {
+  uint8_t ev;
+  tetris_new_game_seeded(&check_game, seed);
+  tetris_frame_reset(&check_timing, level);
+  check_slot = 0;
+  for (ev = 0; ev < 4; ++ev) {
+    check_events[ev] = 0;
+    check_event_slot[ev] = 0;
+  }
+}
+
+/*
+ * Run the next frame slot, with some buttons held.
+ */
+static void check_step(uint8_t held) {
+  ++check_slot;
+  tetris_frame_step(&check_timing, &check_game, held);
+}
+
+/*
+ * Let one brick fall from where it spawns, with or without
+ * 'Down' held, and check that it has dropped the whole rows
+ * that its gravity has added up to after every slot; then,
+ * that it lands in the slot it should, and locks
+ * 'LOCK_DELAY_FRAMES' after that, counting the slot that it
+ * landed in.
+ */
+static void check_fall(uint8_t level, uint8_t held) {
+  uint32_t gravity;
+  uint32_t landed_slot = 0;
+  uint32_t expected;
+  uint32_t brick;
+  int8_t start_y;
+  int8_t land_y;
+  check_start(level + 1, level);
+  gravity = check_timing.gravity;
+  if ((held & TFRAME_HELD_DOWN) && (gravity < SOFT_DROP_GRAVITY)) {
+    gravity = SOFT_DROP_GRAVITY;
+  }
+  start_y = check_game.cur.y;
+  land_y = tetris_landing_row(&check_game);
+  brick = check_game.brick_count;
+  while (check_slot < CHECK_MAX_SLOTS) {
+    check_step(held);
+    if (check_game.brick_count != brick) { break; }
+    expected = ((uint64_t)check_slot * gravity) >> 16;
+    if (expected > (uint32_t)(land_y - start_y)) {
+      expected = land_y - start_y;
+    }
+    if ((uint32_t)(check_game.cur.y - start_y) != expected) {
+      check_fail("rows dropped", check_game.cur.y - start_y, expected);
+      return;
+    }
+    if (!landed_slot && (check_game.cur.y == land_y)) {
+      landed_slot = check_slot;
+    }
+  }
+  if (check_game.brick_count == brick) {
+    check_fail("brick never locked", check_slot, CHECK_MAX_SLOTS);
+    return;
+  }
+  if (check_events[TFRAME_EV_DROP] != (uint32_t)(land_y - start_y)) {
+    check_fail("drop events", check_events[TFRAME_EV_DROP],
+               land_y - start_y);
+  }
+  if (check_events[TFRAME_EV_LOCK] != 1) {
+    check_fail("lock events", check_events[TFRAME_EV_LOCK], 1);
+  }
+  if (check_slot != landed_slot + LOCK_DELAY_FRAMES - 1) {
+    check_fail("lock slot", check_slot,
+               landed_slot + LOCK_DELAY_FRAMES - 1);
+  }
+  // (The first slot whose gravity adds up to the whole fall.)
+  expected = ((((uint64_t)(land_y - start_y)) << 16) + gravity - 1) /
+             gravity;
+  if (!expected) { expected = 1; }
+  if (landed_slot != expected) {
+    check_fail("landing slot", landed_slot, expected);
+  }
+}
+
+/*
+ * With no gravity, hold 'Right' or 'Left' until the brick hits
+ * the wall, and check which slots it moved in. Then let go
+ * and hold the other button, which should start the delay
+ * over again.
+ */
+static void check_shift(uint8_t held, uint8_t ev) {
+  uint32_t moves = 0;
+  uint32_t expected;
+  uint32_t last;
+  check_start(7, 0);
+  check_timing.gravity = 0;
+  while (check_slot < CHECK_MAX_SLOTS) {
+    check_step(held);
+    if (check_events[ev] == moves) { continue; }
+    moves = check_events[ev];
+    expected = SHIFT_DELAY_FRAMES +
+               ((moves - 1) * SHIFT_REPEAT_FRAMES);
+    if (check_event_slot[ev] != expected) {
+      check_fail("shift slot", check_event_slot[ev], expected);
+      return;
+    }
+  }
+  if (moves < 2) {
+    check_fail("shift repeats", moves, 2);
+    return;
+  }
+  if (check_events[TFRAME_EV_DROP] || check_events[TFRAME_EV_LOCK]) {
+    check_fail("ticks without gravity",
+               check_events[TFRAME_EV_DROP] +
+               check_events[TFRAME_EV_LOCK], 0);
+  }
+  // Let go for a slot, then hold the other way.
+  check_step(0);
+  last = check_slot;
+  held ^= (TFRAME_HELD_LEFT | TFRAME_HELD_RIGHT);
+  ev ^= (TFRAME_EV_LEFT ^ TFRAME_EV_RIGHT);
+  while (!check_events[ev] && (check_slot - last < CHECK_MAX_SLOTS)) {
+    check_step(held);
+  }
+  if (check_slot - last != SHIFT_DELAY_FRAMES) {
+    check_fail("shift delay after release", check_slot - last,
+               SHIFT_DELAY_FRAMES);
+  }
+}
+
+int main(void) {
+  uint8_t level;
+  printf("Frame timing at %u Hz: lock delay %u slots, "
+         "auto-repeat %u then every %u.\n", VVC_FRAME_HZ,
+         (uint32_t)LOCK_DELAY_FRAMES, (uint32_t)SHIFT_DELAY_FRAMES,
+         (uint32_t)SHIFT_REPEAT_FRAMES);
+  printf("Gravity at every level...\n");
+  for (level = 0; level <= 20; ++level) {
+    check_fall(level, 0);
+  }
+  printf("Soft drop at every level...\n");
+  for (level = 0; level <= 20; ++level) {
+    check_fall(level, TFRAME_HELD_DOWN);
+  }
+  printf("Auto-repeat...\n");
+  check_shift(TFRAME_HELD_RIGHT, TFRAME_EV_RIGHT);
+  check_shift(TFRAME_HELD_LEFT, TFRAME_EV_LEFT);
+  if (check_failures) {
+    printf("%u check(s) failed.\n", check_failures);
+    return 1;
+  }
+  printf("All checks passed.\n");
+  return 0;
+}
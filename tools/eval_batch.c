@@ -0,0 +1,183 @@
+#include "eval_batch.h"
+
+#ifdef EVAL_HAVE_AVX2
+  #include <immintrin.h>
+#endif
+
+// Row mask for the transitions along a row: the row shifted
+// up by 1, with a wall on either side of it. (Bits 0 and 11)
+#define EVAL_WALLS      (0x801)
+#define EVAL_EDGES_MASK (0x7FF)
+
+// Number of set bits in each 4-bit value.
+static const uint8_t EVAL_BITS4[16] = {
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/*
+ * Count the set bits in a row mask. (Up to 12 bits)
+ */
+static inline uint8_t eval_bits12(uint16_t v) {
+  return EVAL_BITS4[v & 0xF] + EVAL_BITS4[(v >> 4) & 0xF] +
+         EVAL_BITS4[v >> 8];
+}
+
+void eval_pack(eval_batch_t* batch, uint8_t lane, const uint16_t* rows) {
+  uint8_t grid_iy;
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    batch->rows[grid_iy][lane] = rows[grid_iy];
+  }
+}
+
+/*
+ * Work out the features for each grid, one at a time.
+ * Scanning from the top down, a column's height is set by the
+ * first row which has it filled, and every empty cell in a
+ * column which has already been 'covered' is a hole.
+ */
+void eval_batch_scalar(const eval_batch_t* in, eval_out_t* out) {
+  uint16_t covered;
+  uint16_t row;
+  uint16_t new_cols;
+  uint16_t cells;
+  uint16_t edges;
+  uint8_t heights[10];
+  uint8_t lane;
+  uint8_t grid_ix;
+  uint8_t grid_iy;
+  int8_t diff;
+  for (lane = 0; lane < EVAL_LANES; ++lane) {
+    covered = 0;
+    out->holes[lane] = 0;
+    out->bumps[lane] = 0;
+    out->row_trans[lane] = 0;
+    out->lines[lane] = 0;
+    for (grid_ix = 0; grid_ix < 10; ++grid_ix) { heights[grid_ix] = 0; }
+    for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+      row = in->rows[grid_iy][lane];
+      new_cols = row & ~covered;
+      for (grid_ix = 0; new_cols; ++grid_ix, new_cols >>= 1) {
+        if (new_cols & 1) { heights[grid_ix] = 20 - grid_iy; }
+      }
+      covered |= row;
+      cells = covered & ~row;
+      out->holes[lane] += eval_bits12(cells);
+      edges = (row << 1) | EVAL_WALLS;
+      out->row_trans[lane] +=
+        eval_bits12((edges ^ (edges >> 1)) & EVAL_EDGES_MASK);
+      out->lines[lane] += (row == TROW_FULL);
+    }
+    for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+      out->heights[grid_ix][lane] = heights[grid_ix];
+      if (grid_ix < 9) {
+        diff = heights[grid_ix] - heights[grid_ix + 1];
+        out->bumps[lane] += (diff < 0) ? -diff : diff;
+      }
+    }
+  }
+}
+
+#ifdef EVAL_HAVE_AVX2
+/*
+ * Count the set bits in each 16-bit lane, with a 4-bit lookup
+ * table in each 128-bit half. ('vpshufb')
+ */
+__attribute__((target("avx2")))
+static inline __m256i eval_popcount16(__m256i v) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i counts = _mm256_add_epi8(
+    _mm256_shuffle_epi8(lut, _mm256_and_si256(v, nibble)),
+    _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4),
+                                              nibble)));
+  return _mm256_add_epi16(_mm256_and_si256(counts, _mm256_set1_epi16(0xFF)),
+                          _mm256_srli_epi16(counts, 8));
+}
+
+/*
+ * Work out the features for all 16 grids at once.
+ * Holes, transitions and full rows are counted row by row, as
+ * in the scalar version. The heights are counted 'bit-sliced':
+ * a column's height is the number of rows where it's covered,
+ * so each row's 'covered' mask is added into five 1-bit planes
+ * of a counter for every column at once, and the counts are
+ * only pulled out of the planes at the end.
+ */
+__attribute__((target("avx2")))
+void eval_batch_avx2(const eval_batch_t* in, eval_out_t* out) {
+  const __m256i full = _mm256_set1_epi16(TROW_FULL);
+  const __m256i walls = _mm256_set1_epi16(EVAL_WALLS);
+  const __m256i edges_mask = _mm256_set1_epi16(EVAL_EDGES_MASK);
+  const __m256i one = _mm256_set1_epi16(1);
+  __m256i planes[5];
+  __m256i covered = _mm256_setzero_si256();
+  __m256i holes = _mm256_setzero_si256();
+  __m256i trans = _mm256_setzero_si256();
+  __m256i lines = _mm256_setzero_si256();
+  __m256i bumps = _mm256_setzero_si256();
+  __m256i row;
+  __m256i edges;
+  __m256i carry;
+  __m256i next_carry;
+  __m256i height;
+  __m256i last_height = _mm256_setzero_si256();
+  uint8_t plane_i;
+  uint8_t grid_ix;
+  uint8_t grid_iy;
+  for (plane_i = 0; plane_i < 5; ++plane_i) {
+    planes[plane_i] = _mm256_setzero_si256();
+  }
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    row = _mm256_loadu_si256((const __m256i*)in->rows[grid_iy]);
+    covered = _mm256_or_si256(covered, row);
+    holes = _mm256_add_epi16(holes,
+      eval_popcount16(_mm256_andnot_si256(row, covered)));
+    edges = _mm256_or_si256(_mm256_slli_epi16(row, 1), walls);
+    trans = _mm256_add_epi16(trans, eval_popcount16(_mm256_and_si256(
+      _mm256_xor_si256(edges, _mm256_srli_epi16(edges, 1)), edges_mask)));
+    // (Full rows compare to -1.)
+    lines = _mm256_sub_epi16(lines, _mm256_cmpeq_epi16(row, full));
+    carry = covered;
+    for (plane_i = 0; plane_i < 5; ++plane_i) {
+      next_carry = _mm256_and_si256(planes[plane_i], carry);
+      planes[plane_i] = _mm256_xor_si256(planes[plane_i], carry);
+      carry = next_carry;
+    }
+  }
+  for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+    height = _mm256_setzero_si256();
+    for (plane_i = 0; plane_i < 5; ++plane_i) {
+      height = _mm256_or_si256(height, _mm256_sll_epi16(
+        _mm256_and_si256(_mm256_srl_epi16(planes[plane_i],
+                                          _mm_cvtsi32_si128(grid_ix)),
+                         one),
+        _mm_cvtsi32_si128(plane_i)));
+    }
+    _mm256_storeu_si256((__m256i*)out->heights[grid_ix], height);
+    if (grid_ix > 0) {
+      bumps = _mm256_add_epi16(bumps, _mm256_abs_epi16(
+        _mm256_sub_epi16(height, last_height)));
+    }
+    last_height = height;
+  }
+  _mm256_storeu_si256((__m256i*)out->holes, holes);
+  _mm256_storeu_si256((__m256i*)out->bumps, bumps);
+  _mm256_storeu_si256((__m256i*)out->row_trans, trans);
+  _mm256_storeu_si256((__m256i*)out->lines, lines);
+}
+#endif
+
+eval_batch_fn eval_batch_select(const char** name) {
+#ifdef EVAL_HAVE_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    *name = "avx2";
+    return eval_batch_avx2;
+  }
+#endif
+  *name = "scalar";
+  return eval_batch_scalar;
+}
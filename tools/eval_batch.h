@@ -0,0 +1,51 @@
+#ifndef _VVC_EVAL_BATCH_H
+#define _VVC_EVAL_BATCH_H
+
+// Host-side batch evaluator for grids, for searches which
+// score a lot of them. Grids are in the engine's row bitboard
+// form ('tetris_game_t.rows'; bit N = column N), packed 16 to
+// a batch so that SIMD code can work on all of them at once:
+// row 'iy' of every grid in a batch sits side by side, one
+// grid per 16-bit 'lane'.
+// The kernel is picked at runtime: AVX2 on x86 CPUs which have
+// it, or else a plain C version. Both give the same results.
+
+#include "tetris.h"
+
+#define EVAL_LANES (16)
+
+typedef struct {
+  uint16_t rows[20][EVAL_LANES];
+} eval_batch_t;
+
+// Features of each grid in a batch, by lane.
+typedef struct {
+  // How tall the stack is in each column. (As 'heights')
+  uint16_t heights[10][EVAL_LANES];
+  // Empty cells with a filled cell somewhere above them.
+  uint16_t holes[EVAL_LANES];
+  // Sum of the height differences between neighboring columns.
+  uint16_t bumps[EVAL_LANES];
+  // Number of times that each row changes between filled and
+  // empty, walls included. (An empty row has 2)
+  uint16_t row_trans[EVAL_LANES];
+  // Number of full rows.
+  uint16_t lines[EVAL_LANES];
+} eval_out_t;
+
+typedef void (*eval_batch_fn)(const eval_batch_t* in, eval_out_t* out);
+
+// Copy a grid's rows into one lane of a batch.
+void eval_pack(eval_batch_t* batch, uint8_t lane, const uint16_t* rows);
+// The kernels. 'eval_batch_avx2' must only be called if the
+// CPU has AVX2; 'eval_batch_select' checks.
+void eval_batch_scalar(const eval_batch_t* in, eval_out_t* out);
+#if defined(__x86_64__) || defined(__i386__)
+  #define EVAL_HAVE_AVX2
+void eval_batch_avx2(const eval_batch_t* in, eval_out_t* out);
+#endif
+// Pick the fastest kernel which this CPU can run, and set
+// 'name' to what it's called.
+eval_batch_fn eval_batch_select(const char** name);
+
+#endif
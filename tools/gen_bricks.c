@@ -0,0 +1,258 @@
+/*
+ * Host-side generator for 'src/bricks.h'.
+ * The 'BRICKS' shapes in tetris.h are the source of truth;
+ * this decodes them one cell at a time (the slow way) and
+ * either prints the derived tables as a C header, or checks
+ * that the tables which are currently compiled in match.
+ *
+ *   make bricks        Regenerate src/bricks.h
+ *   make check-bricks  Verify src/bricks.h against BRICKS
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "tetris.h"
+
+// Spawn rule: rotation 0, column 4, one row above the grid.
+#define SPAWN_X (4)
+#define SPAWN_Y (-1)
+
+static const char* brick_names = "IOLJTZS";
+
+/*
+ * Decode whether a cell of a brick's 4x4 grid is filled.
+ */
+static int brick_cell(int r, int t, int ix, int iy) {
+  return !!(BRICKS[r][t] & (1 << (3-ix+(3-iy)*4)));
+}
+
+/*
+ * Work out all of the tables for one rotation of a brick.
+ */
+static void brick_derive(int r, int t, uint8_t rows[4],
+                         uint8_t* left, uint8_t* right,
+                         uint8_t* top, uint8_t* bottom,
+                         uint8_t cells[4], int* num_cells,
+                         uint8_t col_bottoms[4]) {
+  int ix, iy;
+  for (ix = 0; ix < 4; ++ix) { col_bottoms[ix] = BRICK_COL_EMPTY; }
+  *left = 3;
+  *right = 0;
+  *top = 3;
+  *bottom = 0;
+  *num_cells = 0;
+  for (iy = 0; iy < 4; ++iy) {
+    rows[iy] = 0;
+    for (ix = 0; ix < 4; ++ix) {
+      if (!brick_cell(r, t, ix, iy)) { continue; }
+      rows[iy] |= (1 << ix);
+      if (ix < *left) { *left = ix; }
+      if (ix > *right) { *right = ix; }
+      if (iy < *top) { *top = iy; }
+      if (iy > *bottom) { *bottom = iy; }
+      col_bottoms[ix] = iy;
+      if (*num_cells < 4) { cells[*num_cells] = BRICK_CELL(ix, iy); }
+      ++(*num_cells);
+    }
+  }
+}
+
+/*
+ * Find the first rotation of a brick which fills the same
+ * cells as rotation 'r', up to a shift. (Possibly 'r' itself)
+ * Compares the two 4x4 grids cell by cell, at every offset.
+ */
+static int brick_same_rot(int r, int t) {
+  int a, dx, dy, ix, iy, same;
+  for (a = 0; a < r; ++a) {
+    for (dy = -3; dy <= 3; ++dy) {
+      for (dx = -3; dx <= 3; ++dx) {
+        same = 1;
+        for (iy = 0; iy < 4 && same; ++iy) {
+          for (ix = 0; ix < 4 && same; ++ix) {
+            if ((ix + dx < 0) || (ix + dx > 3) ||
+                (iy + dy < 0) || (iy + dy > 3)) {
+              same = !brick_cell(r, t, ix, iy);
+            }
+            else {
+              same = (brick_cell(r, t, ix, iy) ==
+                      brick_cell(a, t, ix + dx, iy + dy));
+            }
+          }
+        }
+        if (same) { return a; }
+      }
+    }
+  }
+  return r;
+}
+
+/*
+ * Print one [rotation][type] table of single bytes.
+ */
+static void print_table(const char* name, const char* comment,
+                        int which) {
+  // ('which' 4 is the 'same rotation' table.)
+  int r, t;
+  uint8_t rows[4], cells[4], ext[4], col_b[4];
+  int num_cells;
+  printf("%s", comment);
+  printf("static const uint8_t %s[4][7] = {\n", name);
+  for (r = 0; r < 4; ++r) {
+    printf("  {");
+    for (t = 0; t < 7; ++t) {
+      brick_derive(r, t, rows, &ext[0], &ext[1], &ext[2], &ext[3],
+                   cells, &num_cells, col_b);
+      printf(" %d%s", (which < 4) ? ext[which] : brick_same_rot(r, t),
+             (t < 6) ? "," : " ");
+    }
+    printf("}%s\n", (r < 3) ? "," : "");
+  }
+  printf("};\n");
+}
+
+/*
+ * Print the generated header.
+ */
+static int generate(void) {
+  int r, t, i;
+  uint8_t rows[4], cells[4], ext[4], col_b[4];
+  int num_cells;
+  printf("// Generated by tools/gen_bricks from 'BRICKS' in tetris.h.\n");
+  printf("// Do not edit; run 'make bricks' after changing the shapes.\n");
+  printf("#ifndef _VVC_BRICKS_H\n");
+  printf("#define _VVC_BRICKS_H\n\n");
+  printf("// Each brick row as a mask; bit N is set if column N is\n");
+  printf("// filled. (The left-most column is bit 0.)\n");
+  printf("// Indices: [ rotation ], [ brick type ], [ row ].\n");
+  printf("static const uint8_t BRICK_ROWS[4][7][4] = {\n");
+  for (r = 0; r < 4; ++r) {
+    printf("  {");
+    for (t = 0; t < 7; ++t) {
+      brick_derive(r, t, rows, &ext[0], &ext[1], &ext[2], &ext[3],
+                   cells, &num_cells, col_b);
+      if (num_cells != 4) {
+        fprintf(stderr, "Brick %c, rotation %d has %d cells.\n",
+                brick_names[t], r, num_cells);
+        return 1;
+      }
+      printf("%s{ 0x%X, 0x%X, 0x%X, 0x%X }%s",
+             (t == 0) ? " " : "    ",
+             rows[0], rows[1], rows[2], rows[3],
+             (t < 6) ? ",\n" : " ");
+    }
+    printf("}%s\n", (r < 3) ? "," : "");
+  }
+  printf("};\n");
+  print_table("BRICK_LEFT",
+              "// Left-most and right-most filled columns.\n", 0);
+  print_table("BRICK_RIGHT", "", 1);
+  print_table("BRICK_TOP",
+              "// Top-most and bottom-most filled rows.\n", 2);
+  print_table("BRICK_BOTTOM", "", 3);
+  printf("// The 4 filled cells, top to bottom and left to right;\n");
+  printf("// use 'BRICK_CELL_X' / 'BRICK_CELL_Y' to unpack them.\n");
+  printf("static const uint8_t BRICK_CELLS[4][7][4] = {\n");
+  for (r = 0; r < 4; ++r) {
+    printf("  {");
+    for (t = 0; t < 7; ++t) {
+      brick_derive(r, t, rows, &ext[0], &ext[1], &ext[2], &ext[3],
+                   cells, &num_cells, col_b);
+      printf("%s{ 0x%02X, 0x%02X, 0x%02X, 0x%02X }%s",
+             (t == 0) ? " " : "    ",
+             cells[0], cells[1], cells[2], cells[3],
+             (t < 6) ? ",\n" : " ");
+    }
+    printf("}%s\n", (r < 3) ? "," : "");
+  }
+  printf("};\n");
+  printf("// The bottom-most filled row in each column, or\n");
+  printf("// 'BRICK_COL_EMPTY' for columns with no filled cells.\n");
+  printf("static const uint8_t BRICK_COL_BOTTOM[4][7][4] = {\n");
+  for (r = 0; r < 4; ++r) {
+    printf("  {");
+    for (t = 0; t < 7; ++t) {
+      brick_derive(r, t, rows, &ext[0], &ext[1], &ext[2], &ext[3],
+                   cells, &num_cells, col_b);
+      printf("%s{ 0x%02X, 0x%02X, 0x%02X, 0x%02X }%s",
+             (t == 0) ? " " : "    ",
+             col_b[0], col_b[1], col_b[2], col_b[3],
+             (t < 6) ? ",\n" : " ");
+    }
+    printf("}%s\n", (r < 3) ? "," : "");
+  }
+  printf("};\n");
+  print_table("BRICK_SAME_ROT",
+              "// The first rotation which fills the same cells as\n"
+              "// each one, only shifted; or itself, if none does.\n", 4);
+  printf("// Where each type of brick appears. (Rotation 0)\n");
+  printf("static const int8_t BRICK_SPAWN_X[7] = {");
+  for (i = 0; i < 7; ++i) { printf(" %d%s", SPAWN_X, (i < 6) ? "," : " "); }
+  printf("};\n");
+  printf("static const int8_t BRICK_SPAWN_Y[7] = {");
+  for (i = 0; i < 7; ++i) { printf(" %d%s", SPAWN_Y, (i < 6) ? "," : " "); }
+  printf("};\n\n");
+  printf("#endif\n");
+  return 0;
+}
+
+/*
+ * Compare the compiled-in tables with the 'BRICKS' shapes.
+ */
+static int check(void) {
+  int r, t, i;
+  int errors = 0;
+  uint8_t rows[4], cells[4], ext[4], col_b[4];
+  int num_cells;
+  for (r = 0; r < 4; ++r) {
+    for (t = 0; t < 7; ++t) {
+      brick_derive(r, t, rows, &ext[0], &ext[1], &ext[2], &ext[3],
+                   cells, &num_cells, col_b);
+      if (num_cells != 4) {
+        printf("%c/%d: %d cells in BRICKS\n", brick_names[t], r, num_cells);
+        ++errors;
+      }
+      if (memcmp(rows, BRICK_ROWS[r][t], 4)) {
+        printf("%c/%d: BRICK_ROWS mismatch\n", brick_names[t], r);
+        ++errors;
+      }
+      if (ext[0] != BRICK_LEFT[r][t] || ext[1] != BRICK_RIGHT[r][t] ||
+          ext[2] != BRICK_TOP[r][t] || ext[3] != BRICK_BOTTOM[r][t]) {
+        printf("%c/%d: extents mismatch\n", brick_names[t], r);
+        ++errors;
+      }
+      if (brick_same_rot(r, t) != BRICK_SAME_ROT[r][t]) {
+        printf("%c/%d: BRICK_SAME_ROT mismatch\n", brick_names[t], r);
+        ++errors;
+      }
+      if (memcmp(col_b, BRICK_COL_BOTTOM[r][t], 4)) {
+        printf("%c/%d: BRICK_COL_BOTTOM mismatch\n", brick_names[t], r);
+        ++errors;
+      }
+      // (Every listed cell must be filled, and all different.)
+      for (i = 0; i < 4; ++i) {
+        if (!brick_cell(r, t, BRICK_CELL_X(BRICK_CELLS[r][t][i]),
+                        BRICK_CELL_Y(BRICK_CELLS[r][t][i])) ||
+            (i > 0 && BRICK_CELLS[r][t][i] <= BRICK_CELLS[r][t][i-1])) {
+          printf("%c/%d: BRICK_CELLS[%d] mismatch\n", brick_names[t], r, i);
+          ++errors;
+        }
+      }
+    }
+  }
+  for (t = 0; t < 7; ++t) {
+    if (BRICK_SPAWN_X[t] != SPAWN_X || BRICK_SPAWN_Y[t] != SPAWN_Y) {
+      printf("%c: spawn position mismatch\n", brick_names[t]);
+      ++errors;
+    }
+  }
+  printf("%d brick table errors.\n", errors);
+  return !!errors;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && !strcmp(argv[1], "--check")) {
+    return check();
+  }
+  return generate();
+}
@@ -0,0 +1,51 @@
+/*
+ * Host-side generator for 'src/zobrist.h': the random keys
+ * for hashing grids. (See src/tetris_tt.h) They come from a
+ * fixed-seed xorshift generator, so the header only changes
+ * if the seed or the grid size do.
+ *
+ *   make zobrist       Regenerate src/zobrist.h
+ */
+#include <stdio.h>
+#include <stdint.h>
+
+#define ZOBRIST_SEED (0x9E3779B9)
+
+static uint32_t zobrist_state = ZOBRIST_SEED;
+
+static uint32_t zobrist_next(void) {
+  zobrist_state ^= zobrist_state << 13;
+  zobrist_state ^= zobrist_state >> 17;
+  zobrist_state ^= zobrist_state << 5;
+  return zobrist_state;
+}
+
+int main(void) {
+  int grid_ix, grid_iy, type_i;
+  printf("// Generated by tools/gen_zobrist. Do not edit.\n");
+  printf("#ifndef _VVC_ZOBRIST_H\n");
+  printf("#define _VVC_ZOBRIST_H\n\n");
+  printf("// A random key for each grid cell; a grid's hash is the\n");
+  printf("// XOR of the keys of its filled cells.\n");
+  printf("// Indices: [ row ], [ column ].\n");
+  printf("static const uint32_t ZOBRIST_CELLS[20][10] = {\n");
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    printf("  {");
+    for (grid_ix = 0; grid_ix < 10; ++grid_ix) {
+      printf("%s0x%08X%s", (grid_ix == 5) ? "\n    " : " ",
+             zobrist_next(), (grid_ix < 9) ? "," : " ");
+    }
+    printf("}%s\n", (grid_iy < 19) ? "," : "");
+  }
+  printf("};\n");
+  printf("// A key for each type of brick still to be placed, and\n");
+  printf("// one for none. ('TT_NO_BRICK')\n");
+  printf("static const uint32_t ZOBRIST_TYPES[8] = {\n ");
+  for (type_i = 0; type_i < 8; ++type_i) {
+    printf("%s0x%08X%s", (type_i == 4) ? "\n  " : " ",
+           zobrist_next(), (type_i < 7) ? "," : "");
+  }
+  printf("\n};\n\n");
+  printf("#endif\n");
+  return 0;
+}
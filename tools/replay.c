@@ -0,0 +1,226 @@
+/*
+ * Host-side player for game recordings. (src/replay.h)
+ * Logs are dumps of the firmware's 'replay_log' struct, so
+ * this has to be built with the same 'REPLAY_LOG' size.
+ *
+ *   ./tools/replay LOG           Replay a log, and show how the
+ *                                game ended
+ *   ./tools/replay -b N LOG      ...and time N replays of it
+ *   ./tools/replay -r SEED [LOG] Record a game played by the
+ *                                computer player, check that
+ *                                it replays the same way, and
+ *                                optionally save it
+ *   make check-replay            Run '-r' on a few seeds
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tetris_ai.h"
+#include "replay.h"
+
+// Platform interface: no timers. (Replayed games are seeded
+// from their logs, and game over is read from the game.)
+
+uint32_t tetris_plat_rng_seed(void) {
+  return 0;
+}
+
+void tetris_plat_set_speed(uint8_t level) {
+  (void)level;
+}
+
+void tetris_plat_game_over(void) {
+}
+
+// How a game ended, to compare replays with.
+typedef struct {
+  uint32_t bricks;
+  uint32_t score;
+  uint8_t level;
+  uint8_t game_over;
+  uint32_t grid_hash;
+} replay_result_t;
+
+static replay_log_t log_buf;
+static tetris_game_t game;
+static tetris_ai_t ai;
+
+/*
+ * Sum up a game's state. (FNV-1a over the rows)
+ */
+static void replay_result(const tetris_game_t* g,
+                          replay_result_t* res) {
+  uint8_t grid_iy;
+  memset(res, 0, sizeof(*res));
+  res->bricks = g->brick_count;
+  res->score = tetris_bcd_value(g->score);
+  res->level = tetris_bcd_value(g->level);
+  res->game_over = g->game_over;
+  res->grid_hash = 2166136261u;
+  for (grid_iy = 0; grid_iy < 20; ++grid_iy) {
+    res->grid_hash = (res->grid_hash ^ g->rows[grid_iy]) * 16777619u;
+  }
+}
+
+static void replay_print(const replay_result_t* res) {
+  printf("%u bricks, %u lines, level %u, %s, grid %08X\n",
+         res->bricks, res->score, res->level,
+         res->game_over ? "game over" : "still going",
+         res->grid_hash);
+}
+
+/*
+ * Play a whole log back through the engine.
+ * Returns the number of events.
+ */
+static uint32_t replay_all(replay_result_t* res) {
+  replay_reader_t reader;
+  uint32_t events = 0;
+  replay_start(&reader, &log_buf);
+  while (replay_step(&reader, &game) != REPLAY_EV_END) {
+    ++events;
+  }
+  replay_result(&game, res);
+  return events;
+}
+
+/*
+ * Apply a move to the engine, and record it if it worked,
+ * the same way that the button interrupts do.
+ */
+static uint8_t record_move(tetris_game_t* g, uint8_t ev,
+                           uint32_t* slot) {
+  int8_t new_x = g->cur.x;
+  int8_t new_r = g->cur.r;
+  uint8_t blocked;
+  *slot += 2;
+  if (ev == REPLAY_EV_ROT_CCW) {
+    new_r = (g->cur.r + 1) % 4;
+    blocked = check_brick_rot(g, new_r);
+  }
+  else {
+    new_x += (ev == REPLAY_EV_LEFT) ? -1 : 1;
+    blocked = check_brick_pos(g, new_x, g->cur.y);
+  }
+  if (blocked) { return 0; }
+  g->cur.x = new_x;
+  g->cur.r = new_r;
+  replay_record(&log_buf, ev, *slot);
+  return 1;
+}
+
+/*
+ * Record and apply a gravity tick.
+ */
+static void record_tick(tetris_game_t* g, uint32_t* slot) {
+  *slot += 30;
+  replay_record(&log_buf, REPLAY_EV_TICK, *slot);
+  tetris_game_tick(g);
+}
+
+/*
+ * Record a game, with the computer player choosing where each
+ * brick goes. Every brick gets a gravity tick after turning,
+ * then slides over and is dropped. Stops when the game ends,
+ * or the log is nearly full.
+ */
+static void record_game(tetris_game_t* g, uint32_t seed,
+                        replay_result_t* res) {
+  uint32_t slot = 0;
+  memset(&log_buf, 0, sizeof(log_buf));
+  replay_record_seed(&log_buf, seed, slot);
+  tetris_new_game_seeded(g, seed);
+  while (!g->game_over &&
+         (log_buf.len + 32 < VVC_REPLAY_LOG_SIZE)) {
+    tetris_ai_start(&ai, g->rows, g->cur.type, g->next_type);
+    while (!tetris_ai_step(&ai)) {};
+    while (g->cur.r != ai.best_r &&
+           record_move(g, REPLAY_EV_ROT_CCW, &slot)) {};
+    record_tick(g, &slot);
+    while (g->cur.x < ai.best_x &&
+           record_move(g, REPLAY_EV_RIGHT, &slot)) {};
+    while (g->cur.x > ai.best_x &&
+           record_move(g, REPLAY_EV_LEFT, &slot)) {};
+    if (g->game_over) { break; }
+    slot += 2;
+    g->cur.y = tetris_landing_row(g);
+    replay_record(&log_buf, REPLAY_EV_DROP, slot);
+    record_tick(g, &slot);
+  }
+  replay_result(g, res);
+}
+
+static double replay_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static int usage(void) {
+  fprintf(stderr, "usage: replay [-b N] LOG | replay -r SEED [LOG]\n");
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  replay_result_t rec_res;
+  replay_result_t res;
+  uint32_t events;
+  uint32_t runs = 0;
+  uint32_t run_i;
+  double start;
+  FILE* f;
+  if (argc >= 3 && !strcmp(argv[1], "-r")) {
+    record_game(&game, strtoul(argv[2], NULL, 0), &rec_res);
+    printf("Recorded %u bytes: ", log_buf.len);
+    replay_print(&rec_res);
+    replay_all(&res);
+    if (memcmp(&rec_res, &res, sizeof(res))) {
+      printf("Replay does not match: ");
+      replay_print(&res);
+      return 1;
+    }
+    if (argc > 3) {
+      f = fopen(argv[3], "wb");
+      if (!f || fwrite(&log_buf, sizeof(log_buf), 1, f) != 1) {
+        perror(argv[3]);
+        return 1;
+      }
+      fclose(f);
+    }
+    return 0;
+  }
+  if (argc == 4 && !strcmp(argv[1], "-b")) {
+    runs = strtoul(argv[2], NULL, 0);
+  }
+  else if (argc != 2) {
+    return usage();
+  }
+  f = fopen(argv[argc - 1], "rb");
+  if (!f) {
+    perror(argv[argc - 1]);
+    return 1;
+  }
+  if (fread(&log_buf, sizeof(log_buf), 1, f) != 1 || fgetc(f) != EOF) {
+    fprintf(stderr, "Expected a %u-byte log. (Check REPLAY_LOG)\n",
+            (unsigned)sizeof(log_buf));
+    return 1;
+  }
+  fclose(f);
+  if (!replay_complete(&log_buf)) {
+    fprintf(stderr, "The log doesn't hold a whole game.\n");
+    return 1;
+  }
+  events = replay_all(&res);
+  printf("%u events: ", events);
+  replay_print(&res);
+  if (runs) {
+    start = replay_now();
+    for (run_i = 0; run_i < runs; ++run_i) {
+      replay_all(&res);
+    }
+    printf("%.0f events/s\n", (double)events * runs / (replay_now() - start));
+  }
+  return 0;
+}
@@ -0,0 +1,369 @@
+/*
+ * Host-side self-play tournament for the game engine and the
+ * computer player. (src/tetris.c, src/tetris_ai.c)
+ * Plays one game per seed, on a pool of threads, and reports
+ * how fast they went and how the scores were spread out.
+ * Each game only depends on its seed, and the results are
+ * summed up in seed order, so they come out the same for any
+ * number of threads. (Only the timing and the per-thread
+ * counts change.)
+ * With 'AI_LOOKAHEAD=1', each thread gives its computer player
+ * a transposition table of 2^TT_BITS entries, emptied before
+ * each game; '-c' plays every game again without one, and
+ * reports how many fewer grids the table let it score and how
+ * many games went differently. (Two grids with the same 32-bit
+ * hash get the same score, which happens now and then in a
+ * game of a few hundred bricks; it changes one placement's
+ * score, and usually nothing else.)
+ *
+ *   make tournament                 Build and run it
+ *   ./tools/tournament [-g GAMES] [-s FIRST_SEED] [-j THREADS]
+ *                      [-m MAX_BRICKS] [-t TT_BITS] [-c]
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tetris_ai.h"
+
+// Platform interface: nothing to do. (Every game is seeded,
+// and game over is read from the game.)
+uint32_t tetris_plat_rng_seed(void) {
+  return 0;
+}
+
+void tetris_plat_set_speed(uint8_t level) {
+  (void)level;
+}
+
+void tetris_plat_game_over(void) {
+}
+
+// How one game went.
+typedef struct {
+  uint32_t score;
+  uint32_t bricks;
+  uint8_t level;
+  uint8_t game_over;
+  // Grids that the computer player scored, and its table use.
+  uint64_t evals;
+  uint64_t tt_probes;
+  uint64_t tt_hits;
+} tour_result_t;
+
+// Each thread's share of the games: a range of game numbers,
+// played from the front. A thread which runs out takes the
+// back half of another thread's range. ('work stealing')
+typedef struct {
+  pthread_mutex_t lock;
+  uint32_t next;
+  uint32_t end;
+  uint32_t played;
+  uint32_t stolen;
+} tour_queue_t;
+
+static uint32_t tour_first_seed = 1;
+static uint32_t tour_max_bricks = 2000;
+static uint32_t tour_threads;
+static uint32_t tour_tt_bits = 18;
+static uint8_t tour_compare;
+static tour_queue_t* tour_queues;
+static tour_result_t* tour_results;
+// Results without a transposition table. (With '-c')
+static tour_result_t* tour_base_results;
+
+/*
+ * Play a game with the computer player, until it loses or
+ * has placed 'tour_max_bricks' bricks. Each brick is turned,
+ * slid over, and dropped, as in attract mode; a move which is
+ * blocked ends up dropping the brick early.
+ * 'tt' is the transposition table to use, or NULL.
+ */
+static void tour_play(uint32_t seed, tetris_tt_t* tt,
+                      tour_result_t* res) {
+  tetris_game_t g;
+  tetris_ai_t ai;
+  int8_t new_r;
+  memset(&ai, 0, sizeof(ai));
+#ifdef VVC_AI_LOOKAHEAD
+  if (tt) {
+    tetris_tt_init(tt, tt->entries, tt->mask + 1);
+    ai.tt = tt;
+  }
+#endif
+  tetris_new_game_seeded(&g, seed);
+  while (!g.game_over && g.brick_count < tour_max_bricks) {
+    tetris_ai_start(&ai, g.rows, g.cur.type, g.next_type);
+    while (!tetris_ai_step(&ai)) {};
+    new_r = (g.cur.r + 1) % 4;
+    while ((g.cur.r != ai.best_r) && !check_brick_rot(&g, new_r)) {
+      g.cur.r = new_r;
+      new_r = (g.cur.r + 1) % 4;
+    }
+    while ((g.cur.x < ai.best_x) &&
+           !check_brick_pos(&g, g.cur.x + 1, g.cur.y)) {
+      g.cur.x += 1;
+    }
+    while ((g.cur.x > ai.best_x) &&
+           !check_brick_pos(&g, g.cur.x - 1, g.cur.y)) {
+      g.cur.x -= 1;
+    }
+    g.cur.y = tetris_landing_row(&g);
+    tetris_game_tick(&g);
+  }
+  res->score = tetris_bcd_value(g.score);
+  res->bricks = g.brick_count;
+  res->level = tetris_bcd_value(g.level);
+  res->game_over = g.game_over;
+  res->evals = ai.evals;
+  res->tt_probes = tt ? tt->probes : 0;
+  res->tt_hits = tt ? tt->hits : 0;
+}
+
+/*
+ * Take the next game for a thread to play: from its own range
+ * if there are any left, or else stolen from another's.
+ * Returns 0 once every game has been handed out.
+ */
+static uint8_t tour_take(uint32_t self, uint32_t* game_i) {
+  tour_queue_t* own = &tour_queues[self];
+  tour_queue_t* victim;
+  uint32_t steal;
+  uint32_t thread_i;
+  pthread_mutex_lock(&own->lock);
+  if (own->next < own->end) {
+    *game_i = own->next++;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+  }
+  pthread_mutex_unlock(&own->lock);
+  for (thread_i = 1; thread_i < tour_threads; ++thread_i) {
+    victim = &tour_queues[(self + thread_i) % tour_threads];
+    pthread_mutex_lock(&victim->lock);
+    steal = (victim->end - victim->next + 1) / 2;
+    if (!steal) {
+      pthread_mutex_unlock(&victim->lock);
+      continue;
+    }
+    victim->end -= steal;
+    *game_i = victim->end;
+    pthread_mutex_unlock(&victim->lock);
+    // (Keep the rest of the stolen games, past the first one.)
+    pthread_mutex_lock(&own->lock);
+    own->next = *game_i + 1;
+    own->end = *game_i + steal;
+    ++own->stolen;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+  }
+  return 0;
+}
+
+static void* tour_worker(void* arg) {
+  uint32_t self = (uint32_t)(uintptr_t)arg;
+  uint32_t game_i;
+  tetris_tt_t* use_tt = NULL;
+#ifdef VVC_AI_LOOKAHEAD
+  tetris_tt_t tt;
+  if (tour_tt_bits) {
+    tt.entries = malloc(sizeof(tetris_tt_entry_t) << tour_tt_bits);
+    if (!tt.entries) {
+      perror("malloc");
+      exit(1);
+    }
+    tt.mask = (1UL << tour_tt_bits) - 1;
+    use_tt = &tt;
+  }
+#endif
+  while (tour_take(self, &game_i)) {
+    tour_play(tour_first_seed + game_i, use_tt, &tour_results[game_i]);
+    if (tour_compare) {
+      tour_play(tour_first_seed + game_i, NULL,
+                &tour_base_results[game_i]);
+    }
+    ++tour_queues[self].played;
+  }
+  if (use_tt) { free(use_tt->entries); }
+  return NULL;
+}
+
+static double tour_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+static int tour_cmp_u32(const void* a, const void* b) {
+  uint32_t ua = *(const uint32_t*)a;
+  uint32_t ub = *(const uint32_t*)b;
+  return (ua > ub) - (ua < ub);
+}
+
+/*
+ * Print the spread of a set of per-game values.
+ * (This sorts them.)
+ */
+static void tour_print_spread(const char* name, uint32_t* vals,
+                              uint32_t num) {
+  uint64_t sum = 0;
+  uint32_t val_i;
+  for (val_i = 0; val_i < num; ++val_i) { sum += vals[val_i]; }
+  qsort(vals, num, sizeof(vals[0]), tour_cmp_u32);
+  printf("  %-7s mean %.1f  min %u  p10 %u  p25 %u  median %u  "
+         "p75 %u  p90 %u  max %u\n",
+         name, (double)sum / num, vals[0], vals[num / 10],
+         vals[num / 4], vals[num / 2], vals[(num * 3) / 4],
+         vals[(num * 9) / 10], vals[num - 1]);
+}
+
+/*
+ * Print a histogram of the scores, in 10 equal buckets.
+ * ('scores' must be sorted.)
+ */
+static void tour_print_histogram(const uint32_t* scores, uint32_t num) {
+  uint32_t lo = scores[0];
+  uint32_t width = (scores[num - 1] - lo) / 10 + 1;
+  uint32_t counts[10] = { 0 };
+  uint32_t bucket_i;
+  uint32_t val_i;
+  uint32_t bar;
+  for (val_i = 0; val_i < num; ++val_i) {
+    ++counts[(scores[val_i] - lo) / width];
+  }
+  for (bucket_i = 0; bucket_i < 10; ++bucket_i) {
+    printf("  %6u-%-6u %6u ", lo + bucket_i * width,
+           lo + (bucket_i + 1) * width - 1, counts[bucket_i]);
+    for (bar = 0; bar < (counts[bucket_i] * 50 + num - 1) / num; ++bar) {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+}
+
+static int usage(void) {
+  fprintf(stderr, "usage: tournament [-g GAMES] [-s FIRST_SEED] "
+                  "[-j THREADS] [-m MAX_BRICKS]\n"
+                  "                  [-t TT_BITS] [-c]\n");
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  pthread_t* threads;
+  uint32_t* scores;
+  uint32_t* bricks;
+  uint32_t games = 1000;
+  uint32_t thread_i;
+  uint32_t game_i;
+  uint32_t lost = 0;
+  uint32_t differ = 0;
+  uint64_t total_bricks = 0;
+  uint64_t evals = 0;
+  uint64_t base_evals = 0;
+  uint64_t tt_probes = 0;
+  uint64_t tt_hits = 0;
+  uint32_t hash = 2166136261u;
+  double start;
+  double secs;
+  int opt;
+  tour_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc, argv, "g:s:j:m:t:c")) != -1) {
+    if (opt == 'g') { games = strtoul(optarg, NULL, 0); }
+    else if (opt == 's') { tour_first_seed = strtoul(optarg, NULL, 0); }
+    else if (opt == 'j') { tour_threads = strtoul(optarg, NULL, 0); }
+    else if (opt == 'm') { tour_max_bricks = strtoul(optarg, NULL, 0); }
+    else if (opt == 't') { tour_tt_bits = strtoul(optarg, NULL, 0); }
+    else if (opt == 'c') { tour_compare = 1; }
+    else { return usage(); }
+  }
+  if (!games || !tour_threads || (tour_tt_bits > 28) || optind != argc) {
+    return usage();
+  }
+#ifndef VVC_AI_LOOKAHEAD
+  // (Only the lookahead uses a table.)
+  tour_tt_bits = 0;
+#endif
+  threads = calloc(tour_threads, sizeof(*threads));
+  tour_queues = calloc(tour_threads, sizeof(*tour_queues));
+  tour_results = calloc(games, sizeof(*tour_results));
+  scores = calloc(games, sizeof(*scores));
+  bricks = calloc(games, sizeof(*bricks));
+  tour_base_results = calloc(games, sizeof(*tour_base_results));
+  if (!threads || !tour_queues || !tour_results || !scores || !bricks ||
+      !tour_base_results) {
+    perror("calloc");
+    return 1;
+  }
+  // Deal the games out evenly to start with.
+  for (thread_i = 0; thread_i < tour_threads; ++thread_i) {
+    pthread_mutex_init(&tour_queues[thread_i].lock, NULL);
+    tour_queues[thread_i].next =
+      (uint64_t)games * thread_i / tour_threads;
+    tour_queues[thread_i].end =
+      (uint64_t)games * (thread_i + 1) / tour_threads;
+  }
+  start = tour_now();
+  for (thread_i = 0; thread_i < tour_threads; ++thread_i) {
+    if (pthread_create(&threads[thread_i], NULL, tour_worker,
+                       (void*)(uintptr_t)thread_i)) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+  for (thread_i = 0; thread_i < tour_threads; ++thread_i) {
+    pthread_join(threads[thread_i], NULL);
+  }
+  secs = tour_now() - start;
+
+  // Sum up, in seed order.
+  for (game_i = 0; game_i < games; ++game_i) {
+    scores[game_i] = tour_results[game_i].score;
+    bricks[game_i] = tour_results[game_i].bricks;
+    total_bricks += tour_results[game_i].bricks;
+    lost += tour_results[game_i].game_over;
+    hash = (hash ^ tour_results[game_i].score) * 16777619u;
+    hash = (hash ^ tour_results[game_i].bricks) * 16777619u;
+    hash = (hash ^ tour_results[game_i].game_over) * 16777619u;
+    evals += tour_results[game_i].evals;
+    tt_probes += tour_results[game_i].tt_probes;
+    tt_hits += tour_results[game_i].tt_hits;
+    base_evals += tour_base_results[game_i].evals;
+    differ += tour_compare &&
+      ((tour_results[game_i].score != tour_base_results[game_i].score) ||
+       (tour_results[game_i].bricks != tour_base_results[game_i].bricks));
+  }
+  printf("%u games (seeds %u-%u, up to %u bricks), %u threads, "
+         "%.3fs\n", games, tour_first_seed, tour_first_seed + games - 1,
+         tour_max_bricks, tour_threads, secs);
+  printf("  games/s:  %.1f\n", games / secs);
+  printf("  bricks/s: %.0f\n", total_bricks / secs);
+  for (thread_i = 0; thread_i < tour_threads; ++thread_i) {
+    printf("  thread %u: %u games, %u steals\n", thread_i,
+           tour_queues[thread_i].played, tour_queues[thread_i].stolen);
+  }
+  printf("Computer player: %.1f grids scored per brick\n",
+         (double)evals / total_bricks);
+  if (tour_tt_bits) {
+    printf("  table: 2^%u entries (%lu bytes) per thread; %llu lookups, "
+           "%.1f%% found\n", tour_tt_bits,
+           (unsigned long)(sizeof(tetris_tt_entry_t) << tour_tt_bits),
+           (unsigned long long)tt_probes,
+           tt_probes ? (100.0 * tt_hits) / tt_probes : 0.0);
+  }
+  if (tour_compare) {
+    printf("  without it: %.1f grids scored per brick (%.1f%% fewer "
+           "with it); %u games went differently\n",
+           (double)base_evals / total_bricks,
+           base_evals ? 100.0 - (100.0 * evals) / base_evals : 0.0,
+           differ);
+  }
+  printf("Results: %u lost, %u still going; hash %08X\n",
+         lost, games - lost, hash);
+  tour_print_spread("lines", scores, games);
+  tour_print_spread("bricks", bricks, games);
+  printf("Lines per game:\n");
+  tour_print_histogram(scores, games);
+  return 0;
+}